@@ -387,4 +387,33 @@ static inline void flush_cache_vunmap(unsigned long start, unsigned long end)
 	}
 }
 
+/*
+ * The vmap layer defers the TLB flush of most unmapped areas to a later
+ * purge.  For those, flush_cache_vunmap_lazy() is used at unmap time and
+ * flush_cache_vunmap_purge() once per purge, before the addresses are
+ * handed out again.  On VIVT caches, a small area then only needs its
+ * own D-cache lines written back and invalidated (lookups by MVA don't
+ * go through the page tables), rather than the whole cache, and the
+ * I-cache is invalidated once for the whole batch.
+ */
+#define ARCH_HAS_LAZY_VUNMAP_FLUSH
+
+#define VUNMAP_RANGE_FLUSH_MAX	(16 * 1024)
+
+static inline void flush_cache_vunmap_lazy(unsigned long start,
+					   unsigned long end)
+{
+	if (cache_is_vivt() && end - start <= VUNMAP_RANGE_FLUSH_MAX)
+		__cpuc_flush_dcache_area((void *)start, end - start);
+	else
+		flush_cache_vunmap(start, end);
+}
+
+static inline void flush_cache_vunmap_purge(unsigned long start,
+					    unsigned long end)
+{
+	if (cache_is_vivt())
+		__flush_icache_all();
+}
+
 #endif
@@ -179,6 +179,33 @@ switch_mm(struct mm_struct *prev, struct mm_struct *next,
 #endif
 }
 
+#ifdef CONFIG_SCHED_MM_SWITCH_COST
+/*
+ * Whether switching from @prev to @next flushes the caches; for the
+ * scheduler, so this is only a guess for the best effort FCSE.
+ */
+static inline int arch_mm_switch_flushes(struct mm_struct *prev,
+					 struct mm_struct *next)
+{
+	if (!cache_is_vivt())
+		return 0;
+#if defined(CONFIG_ARM_FCSE_BEST_EFFORT)
+	if (prev->context.fcse.shared_dirty_pages
+	    || prev->context.fcse.high_pages
+	    || next->context.fcse.high_pages)
+		return 1;
+	/* The pid of @next is dirty with the data of another mm */
+	return !fcse_mm_in_cache(next)
+		&& test_bit(next->context.fcse.pid >> FCSE_PID_SHIFT,
+			    fcse_pids_cache_dirty);
+#elif defined(CONFIG_ARM_FCSE_GUARANTEED)
+	return 0;
+#else
+	return 1;
+#endif
+}
+#endif
+
 #define deactivate_mm(tsk,mm)	do { } while (0)
 
 #ifndef CONFIG_ARM_FCSE_BEST_EFFORT
@@ -62,6 +62,8 @@ struct driver_private {
  * list soon.
  * @device - pointer back to the struct class that this structure is
  * associated with.
+ * @probe_done - pending while the device is being probed, or waits to be
+ * probed asynchronously.
  *
  * Nothing outside of the driver core should ever touch these fields.
  */
@@ -72,6 +74,9 @@ struct device_private {
 	struct klist_node knode_bus;
 	void *driver_data;
 	struct device *device;
+#ifdef CONFIG_DRIVER_ASYNC_PROBE
+	struct completion probe_done;
+#endif
 };
 #define to_device_private_parent(obj)	\
 	container_of(obj, struct device_private, knode_parent)
@@ -105,6 +110,7 @@ extern void bus_remove_driver(struct device_driver *drv);
 
 extern void driver_detach(struct device_driver *drv);
 extern int driver_probe_device(struct device_driver *drv, struct device *dev);
+extern int device_initial_probe(struct device *dev);
 static inline int driver_match_device(struct device_driver *drv,
 				      struct device *dev)
 {
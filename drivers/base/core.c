@@ -869,6 +869,10 @@ int device_private_init(struct device *dev)
 	dev->p->device = dev;
 	klist_init(&dev->p->klist_children, klist_children_get,
 		   klist_children_put);
+#ifdef CONFIG_DRIVER_ASYNC_PROBE
+	init_completion(&dev->p->probe_done);
+	complete_all(&dev->p->probe_done);
+#endif
 	return 0;
 }
 
@@ -23,7 +23,13 @@
 #include <linux/kthread.h>
 #include <linux/wait.h>
 #include <linux/async.h>
+#include <linux/boot_profile.h>
+#include <linux/init.h>
+#include <linux/ktime.h>
+#include <linux/platform_device.h>
 #include <linux/pm_runtime.h>
+#include <linux/slab.h>
+#include <linux/string.h>
 
 #include "base.h"
 #include "power/power.h"
@@ -105,11 +111,72 @@ EXPORT_SYMBOL_GPL(device_bind_driver);
 static atomic_t probe_count = ATOMIC_INIT(0);
 static DECLARE_WAIT_QUEUE_HEAD(probe_waitqueue);
 
+#ifdef CONFIG_DRIVER_ASYNC_PROBE
+/*
+ * While a device is being probed, or waits to be probed asynchronously,
+ * its probe_done completion is pending: the asynchronous probes of its
+ * children wait for it.
+ */
+static inline void probe_start(struct device *dev)
+{
+	INIT_COMPLETION(dev->p->probe_done);
+}
+
+static inline void probe_done(struct device *dev)
+{
+	complete_all(&dev->p->probe_done);
+}
+#else
+static inline void probe_start(struct device *dev)
+{
+}
+
+static inline void probe_done(struct device *dev)
+{
+}
+#endif
+
+/* With initcall_debug, the probes are timed like the initcalls */
+static int call_driver_probe(struct device *dev, struct device_driver *drv)
+{
+	ktime_t calltime, delta;
+	u64 start = boot_profile_start();
+	int ret = 0;
+
+	if (initcall_debug) {
+		printk(KERN_DEBUG "probing  %s/%s @ %i\n", drv->name,
+		       dev_name(dev), task_pid_nr(current));
+		calltime = ktime_get();
+	}
+
+	if (dev->bus->probe)
+		ret = dev->bus->probe(dev);
+	else if (drv->probe)
+		ret = drv->probe(dev);
+
+	if (initcall_debug) {
+		delta = ktime_sub(ktime_get(), calltime);
+		printk(KERN_DEBUG "probe    %s/%s returned %d after %lld usecs\n",
+		       drv->name, dev_name(dev), ret,
+		       (unsigned long long)ktime_to_ns(delta) >> 10);
+	}
+
+	if (start) {
+		char name[32];
+
+		snprintf(name, sizeof(name), "%s/%s", drv->name, dev_name(dev));
+		boot_profile_record(BOOT_PROFILE_PROBE, NULL, name, start, ret);
+	}
+
+	return ret;
+}
+
 static int really_probe(struct device *dev, struct device_driver *drv)
 {
 	int ret = 0;
 
 	atomic_inc(&probe_count);
+	probe_start(dev);
 	pr_debug("bus: '%s': %s: probing driver %s with device %s\n",
 		 drv->bus->name, __func__, drv->name, dev_name(dev));
 	WARN_ON(!list_empty(&dev->devres_head));
@@ -121,15 +188,9 @@ static int really_probe(struct device *dev, struct device_driver *drv)
 		goto probe_failed;
 	}
 
-	if (dev->bus->probe) {
-		ret = dev->bus->probe(dev);
-		if (ret)
-			goto probe_failed;
-	} else if (drv->probe) {
-		ret = drv->probe(dev);
-		if (ret)
-			goto probe_failed;
-	}
+	ret = call_driver_probe(dev, drv);
+	if (ret)
+		goto probe_failed;
 
 	driver_bound(dev);
 	ret = 1;
@@ -154,6 +215,7 @@ probe_failed:
 	 */
 	ret = 0;
 done:
+	probe_done(dev);
 	atomic_dec(&probe_count);
 	wake_up(&probe_waitqueue);
 	return ret;
@@ -186,6 +248,132 @@ void wait_for_device_probe(void)
 }
 EXPORT_SYMBOL_GPL(wait_for_device_probe);
 
+#ifdef CONFIG_DRIVER_ASYNC_PROBE
+/* Asynchronous probes run in their own domain */
+static LIST_HEAD(async_probe_domain);
+
+static char async_probe_drivers[128];
+
+static int __init save_async_probe_drivers(char *str)
+{
+	strlcpy(async_probe_drivers, str, sizeof(async_probe_drivers));
+	return 1;
+}
+__setup("driver_async_probe=", save_async_probe_drivers);
+
+static bool driver_allows_async_probing(struct device_driver *drv)
+{
+	const char *name = async_probe_drivers;
+	size_t len = strlen(drv->name);
+
+	/*
+	 * Asynchronous probes don't hold the parent's lock, which other
+	 * buses (USB) need: keep to platform devices.
+	 */
+	if (drv->bus != &platform_bus_type)
+		return false;
+
+	if (drv->async_probe)
+		return true;
+
+	/* Drivers named in driver_async_probe=<name>,<name>... */
+	while (*name) {
+		if (!strncmp(name, drv->name, len) &&
+		    (name[len] == ',' || !name[len]))
+			return true;
+		name = strchr(name, ',');
+		if (!name)
+			break;
+		name++;
+	}
+	return false;
+}
+
+struct async_probe {
+	struct device *dev;
+	struct device_driver *drv;
+};
+
+static void async_probe_device(void *data, async_cookie_t cookie)
+{
+	struct async_probe *ap = data;
+	struct device *dev = ap->dev;
+
+	/* Children wait for their parent, e.g. MFD cells or regulator
+	 * consumers registered once the supply is bound */
+	if (dev->parent && dev->parent->p)
+		wait_for_completion(&dev->parent->p->probe_done);
+
+	device_lock(dev);
+	if (!dev->driver)
+		driver_probe_device(ap->drv, dev);
+	device_unlock(dev);
+
+	probe_done(dev);
+	put_device(dev);
+	kfree(ap);
+
+	atomic_dec(&probe_count);
+	wake_up(&probe_waitqueue);
+}
+
+/*
+ * Queue the probe of @dev by @drv, returning 1 as if it had been bound.
+ * Must be called with @dev lock held.
+ */
+static int driver_probe_device_async(struct device_driver *drv,
+				     struct device *dev)
+{
+	struct async_probe *ap;
+
+	if (!device_is_registered(dev))
+		return -ENODEV;
+
+	ap = kmalloc(sizeof(*ap), GFP_KERNEL);
+	if (!ap)
+		return driver_probe_device(drv, dev);
+
+	ap->dev = get_device(dev);
+	ap->drv = drv;
+	atomic_inc(&probe_count);
+	probe_start(dev);
+
+	pr_debug("bus: '%s': %s: probing device %s with driver %s "
+		 "asynchronously\n", drv->bus->name, __func__,
+		 dev_name(dev), drv->name);
+	async_schedule_domain(async_probe_device, ap, &async_probe_domain);
+	return 1;
+}
+
+static void async_probe_synchronize(void)
+{
+	async_synchronize_full_domain(&async_probe_domain);
+}
+
+/* Don't let init run with devices still being probed */
+static int __init async_probe_sync_init(void)
+{
+	async_probe_synchronize();
+	return 0;
+}
+late_initcall_sync(async_probe_sync_init);
+#else
+static inline bool driver_allows_async_probing(struct device_driver *drv)
+{
+	return false;
+}
+
+static inline int driver_probe_device_async(struct device_driver *drv,
+					    struct device *dev)
+{
+	return driver_probe_device(drv, dev);
+}
+
+static inline void async_probe_synchronize(void)
+{
+}
+#endif /* CONFIG_DRIVER_ASYNC_PROBE */
+
 /**
  * driver_probe_device - attempt to bind device & driver together
  * @drv: driver to bind a device to
@@ -215,32 +403,31 @@ int driver_probe_device(struct device_driver *drv, struct device *dev)
 	return ret;
 }
 
-static int __device_attach(struct device_driver *drv, void *data)
+struct device_attach_data {
+	struct device *dev;
+	bool allow_async;
+};
+
+static int __device_attach(struct device_driver *drv, void *_data)
 {
-	struct device *dev = data;
+	struct device_attach_data *data = _data;
+	struct device *dev = data->dev;
 
 	if (!driver_match_device(drv, dev))
 		return 0;
 
+	if (data->allow_async && driver_allows_async_probing(drv))
+		return driver_probe_device_async(drv, dev);
+
 	return driver_probe_device(drv, dev);
 }
 
-/**
- * device_attach - try to attach device to a driver.
- * @dev: device.
- *
- * Walk the list of drivers that the bus has and call
- * driver_probe_device() for each pair. If a compatible
- * pair is found, break out and return.
- *
- * Returns 1 if the device was bound to a driver;
- * 0 if no matching driver was found;
- * -ENODEV if the device is not registered.
- *
- * When called for a USB interface, @dev->parent lock must be held.
- */
-int device_attach(struct device *dev)
+static int __device_attach_common(struct device *dev, bool allow_async)
 {
+	struct device_attach_data data = {
+		.dev = dev,
+		.allow_async = allow_async,
+	};
 	int ret = 0;
 
 	device_lock(dev);
@@ -254,14 +441,42 @@ int device_attach(struct device *dev)
 		}
 	} else {
 		pm_runtime_get_noresume(dev);
-		ret = bus_for_each_drv(dev->bus, NULL, dev, __device_attach);
+		ret = bus_for_each_drv(dev->bus, NULL, &data, __device_attach);
 		pm_runtime_put_sync(dev);
 	}
 	device_unlock(dev);
 	return ret;
 }
+
+/**
+ * device_attach - try to attach device to a driver.
+ * @dev: device.
+ *
+ * Walk the list of drivers that the bus has and call
+ * driver_probe_device() for each pair. If a compatible
+ * pair is found, break out and return.
+ *
+ * Returns 1 if the device was bound to a driver;
+ * 0 if no matching driver was found;
+ * -ENODEV if the device is not registered.
+ *
+ * When called for a USB interface, @dev->parent lock must be held.
+ */
+int device_attach(struct device *dev)
+{
+	return __device_attach_common(dev, false);
+}
 EXPORT_SYMBOL_GPL(device_attach);
 
+/*
+ * device_initial_probe - device_attach() for a newly added device, which
+ * may be probed asynchronously if its driver allows it.
+ */
+int device_initial_probe(struct device *dev)
+{
+	return __device_attach_common(dev, true);
+}
+
 static int __driver_attach(struct device *dev, void *data)
 {
 	struct device_driver *drv = data;
@@ -279,6 +494,14 @@ static int __driver_attach(struct device *dev, void *data)
 	if (!driver_match_device(drv, dev))
 		return 0;
 
+	if (driver_allows_async_probing(drv)) {
+		device_lock(dev);
+		if (!dev->driver)
+			driver_probe_device_async(drv, dev);
+		device_unlock(dev);
+		return 0;
+	}
+
 	if (dev->parent)	/* Needed for USB */
 		device_lock(dev->parent);
 	device_lock(dev);
@@ -371,6 +594,9 @@ void driver_detach(struct device_driver *drv)
 	struct device_private *dev_prv;
 	struct device *dev;
 
+	/* Asynchronous probes may still use drv */
+	async_probe_synchronize();
+
 	for (;;) {
 		spin_lock(&drv->p->klist_devices.k_lock);
 		if (list_empty(&drv->p->klist_devices.k_list)) {
@@ -919,6 +919,7 @@ static struct platform_driver glamo_mci_driver = {
 		.name	= "glamo-mci",
 		.owner	= THIS_MODULE,
 		.pm	= GLAMO_MCI_PM_OPS,
+		.async_probe = true,
 	},
 };
 
@@ -1907,6 +1907,7 @@ static struct platform_driver s3cmci_driver = {
 		.name	= "s3c-sdi",
 		.owner	= THIS_MODULE,
 		.pm	= s3cmci_pm_ops,
+		.async_probe = true,
 	},
 	.id_table	= s3cmci_driver_ids,
 	.probe		= s3cmci_probe,
@@ -20,6 +20,7 @@
 #include <linux/errno.h>
 #include <linux/highmem.h>
 #include <linux/init.h>
+#include <linux/sched.h>
 #include <linux/string.h>
 #include <linux/slab.h>
 
@@ -85,6 +86,30 @@ static struct block_header *BLOCK_NEXT(struct block_header *block)
 		((char *)block + block->size + XV_ALIGN);
 }
 
+/*
+ * Get the histogram bucket for the given number of bytes: these
+ * split [0, PAGE_SIZE] into XV_HIST_BUCKETS ranges.
+ */
+static u32 hist_bucket(u32 bytes)
+{
+	return min_t(u32, bytes / (PAGE_SIZE / XV_HIST_BUCKETS),
+			XV_HIST_BUCKETS - 1);
+}
+
+/*
+ * Account for 'delta' bytes allocated in (or, if negative, freed
+ * from) the given page.
+ */
+static void page_used_add(struct xv_pool *pool, struct page *page, int delta)
+{
+	u32 used = page_private(page);
+
+	pool->fill_hist[hist_bucket(used)]--;
+	used += delta;
+	set_page_private(page, used);
+	pool->fill_hist[hist_bucket(used)]++;
+}
+
 /*
  * Get index of free list containing blocks of maximum size
  * which is less than or equal to given size.
@@ -284,6 +309,11 @@ static int grow_pool(struct xv_pool *pool, gfp_t flags)
 	stat_inc(&pool->total_pages);
 
 	spin_lock(&pool->lock);
+	set_page_private(page, 0);
+	page->index = 0;
+	list_add(&page->lru, &pool->pages);
+	pool->fill_hist[0]++;
+
 	block = get_ptr_atomic(page, 0, KM_USER0);
 
 	block->size = PAGE_SIZE - XV_ALIGN;
@@ -314,6 +344,7 @@ struct xv_pool *xv_create_pool(void)
 		return NULL;
 
 	spin_lock_init(&pool->lock);
+	INIT_LIST_HEAD(&pool->pages);
 
 	return pool;
 }
@@ -336,6 +367,8 @@ EXPORT_SYMBOL_GPL(xv_destroy_pool);
  * and 0 is returned. On failure, <page, offset> is set to
  * 0 and -ENOMEM is returned.
  *
+ * The pool only grows if flags allow the allocation to sleep.
+ *
  * Allocation requests with size > XV_MAX_ALLOC_SIZE will fail.
  */
 int xv_malloc(struct xv_pool *pool, u32 size, struct page **page,
@@ -360,7 +393,7 @@ int xv_malloc(struct xv_pool *pool, u32 size, struct page **page,
 
 	if (!*page) {
 		spin_unlock(&pool->lock);
-		if (flags & GFP_NOWAIT)
+		if (!(flags & __GFP_WAIT))
 			return -ENOMEM;
 		error = grow_pool(pool, flags);
 		if (unlikely(error))
@@ -405,6 +438,9 @@ int xv_malloc(struct xv_pool *pool, u32 size, struct page **page,
 	block->size = origsize;
 	clear_flag(block, BLOCK_FREE);
 
+	page_used_add(pool, *page, size + XV_ALIGN);
+	pool->size_hist[hist_bucket(origsize)]++;
+
 	put_ptr_atomic(block, KM_USER0);
 	spin_unlock(&pool->lock);
 
@@ -432,7 +468,9 @@ void xv_free(struct xv_pool *pool, struct page *page, u32 offset)
 	/* Catch double free bugs */
 	BUG_ON(test_flag(block, BLOCK_FREE));
 
+	pool->size_hist[hist_bucket(block->size)]--;
 	block->size = ALIGN(block->size, XV_ALIGN);
+	page_used_add(pool, page, -(block->size + XV_ALIGN));
 
 	tmpblock = BLOCK_NEXT(block);
 	if (offset + block->size + XV_ALIGN == PAGE_SIZE)
@@ -469,6 +507,10 @@ void xv_free(struct xv_pool *pool, struct page *page, u32 offset)
 	/* No used objects in this page. Free it. */
 	if (block->size == PAGE_SIZE - XV_ALIGN) {
 		put_ptr_atomic(page_start, KM_USER0);
+		pool->fill_hist[0]--;
+		list_del_init(&page->lru);
+		if (page == pool->isolated)
+			pool->isolated = NULL;
 		spin_unlock(&pool->lock);
 
 		__free_page(page);
@@ -477,8 +519,13 @@ void xv_free(struct xv_pool *pool, struct page *page, u32 offset)
 	}
 
 	set_flag(block, BLOCK_FREE);
-	if (block->size >= XV_MIN_ALLOC_SIZE)
-		insert_block(pool, page, offset, block);
+	if (block->size >= XV_MIN_ALLOC_SIZE) {
+		/* Free space of a page being compacted stays unused */
+		if (page != pool->isolated)
+			insert_block(pool, page, offset, block);
+		else
+			memset(&block->link, 0, sizeof(block->link));
+	}
 
 	if (offset + block->size + XV_ALIGN != PAGE_SIZE) {
 		tmpblock = BLOCK_NEXT(block);
@@ -508,3 +555,172 @@ u64 xv_get_total_size_bytes(struct xv_pool *pool)
 	return pool->total_pages << PAGE_SHIFT;
 }
 EXPORT_SYMBOL_GPL(xv_get_total_size_bytes);
+
+/*
+ * Get the number of pool pages in each of XV_HIST_BUCKETS ranges of
+ * bytes in use, the first being the least used pages.
+ */
+void xv_get_fill_histogram(struct xv_pool *pool, u32 *hist)
+{
+	spin_lock(&pool->lock);
+	memcpy(hist, pool->fill_hist, sizeof(pool->fill_hist));
+	spin_unlock(&pool->lock);
+}
+EXPORT_SYMBOL_GPL(xv_get_fill_histogram);
+
+/*
+ * Get the number of allocated objects in each of XV_HIST_BUCKETS
+ * size ranges, the first being the smallest objects.
+ */
+void xv_get_size_histogram(struct xv_pool *pool, u32 *hist)
+{
+	spin_lock(&pool->lock);
+	memcpy(hist, pool->size_hist, sizeof(pool->size_hist));
+	spin_unlock(&pool->lock);
+}
+EXPORT_SYMBOL_GPL(xv_get_size_histogram);
+
+/*
+ * Take the free blocks of a page off the freelists, so that nothing
+ * gets allocated in it while its objects are moved elsewhere. The
+ * offsets of these objects are stored in objs, and their number is
+ * returned.
+ */
+static u32 isolate_page(struct xv_pool *pool, struct page *page, u16 *objs)
+{
+	u32 offset, nr_objs = 0;
+	char *page_start;
+	struct block_header *block;
+
+	page_start = get_ptr_atomic(page, 0, KM_USER0);
+	for (offset = 0; offset < PAGE_SIZE;
+			offset += ALIGN(block->size, XV_ALIGN) + XV_ALIGN) {
+		block = (struct block_header *)(page_start + offset);
+		if (!test_flag(block, BLOCK_FREE))
+			objs[nr_objs++] = offset + XV_ALIGN;
+		else if (block->size >= XV_MIN_ALLOC_SIZE)
+			remove_block(pool, page, offset, block,
+				    get_index_for_insert(block->size));
+	}
+	put_ptr_atomic(page_start, KM_USER0);
+
+	pool->isolated = page;
+
+	return nr_objs;
+}
+
+/*
+ * Put the free blocks of a page isolated by isolate_page()
+ * back on the freelists.
+ */
+static void release_page(struct xv_pool *pool, struct page *page)
+{
+	u32 offset;
+	char *page_start;
+	struct block_header *block;
+
+	page_start = get_ptr_atomic(page, 0, KM_USER0);
+	for (offset = 0; offset < PAGE_SIZE;
+			offset += ALIGN(block->size, XV_ALIGN) + XV_ALIGN) {
+		block = (struct block_header *)(page_start + offset);
+		if (test_flag(block, BLOCK_FREE) &&
+				block->size >= XV_MIN_ALLOC_SIZE)
+			insert_block(pool, page, offset, block);
+	}
+	put_ptr_atomic(page_start, KM_USER0);
+
+	pool->isolated = NULL;
+}
+
+/**
+ * xv_compact - move objects out of sparsely used pages
+ * @pool: pool to compact
+ * @migrate: called to move the object at <page, offset>
+ * @data: passed on to @migrate
+ *
+ * Pages which are at most half used are emptied one at a time: their
+ * free space is withheld from allocations and @migrate is called for
+ * each of their objects. It is expected to xv_malloc() a new object
+ * with GFP_NOWAIT, so that only free space of other pages is used,
+ * copy the data, update its references and xv_free() the old object.
+ * It returns 0 if the object was moved, -ENOMEM to end compaction
+ * and any other error to leave the object where it is.
+ *
+ * Objects may be freed during compaction, in which case @migrate can
+ * be passed stale offsets. Callers must tell these apart, and keep
+ * objects from being freed while they move them.
+ *
+ * Returns the number of objects moved, or -ENOMEM.
+ */
+int xv_compact(struct xv_pool *pool,
+		int (*migrate)(void *data, struct page *page, u32 offset),
+		void *data)
+{
+	int moved = 0, stop = 0;
+	u16 *objs;
+	u32 i, j, nr, nr_objs, seq;
+	struct page *page, *batch[XV_COMPACT_BATCH];
+
+	/* Smallest blocks: XV_ALIGN bytes of data and the header */
+	objs = kmalloc(PAGE_SIZE / (2 * XV_ALIGN) * sizeof(*objs),
+			GFP_KERNEL);
+	if (!objs)
+		return -ENOMEM;
+
+	spin_lock(&pool->lock);
+	seq = ++pool->compact_seq;
+	spin_unlock(&pool->lock);
+
+	do {
+		/* Pick the next few sparse pages not yet seen by this pass */
+		nr = 0;
+		spin_lock(&pool->lock);
+		list_for_each_entry(page, &pool->pages, lru) {
+			if (page->index == seq ||
+					page_private(page) > XV_COMPACT_SPARSE)
+				continue;
+
+			page->index = seq;
+			get_page(page);
+			batch[nr++] = page;
+			if (nr == XV_COMPACT_BATCH)
+				break;
+		}
+		spin_unlock(&pool->lock);
+
+		for (i = 0; i < nr; i++) {
+			page = batch[i];
+
+			/* Its last object may have been freed meanwhile */
+			nr_objs = 0;
+			spin_lock(&pool->lock);
+			if (!stop && !list_empty(&page->lru))
+				nr_objs = isolate_page(pool, page, objs);
+			spin_unlock(&pool->lock);
+
+			for (j = 0; j < nr_objs; j++) {
+				int ret = migrate(data, page, objs[j]);
+
+				if (!ret)
+					moved++;
+				if (ret == -ENOMEM) {
+					stop = 1;
+					break;
+				}
+			}
+
+			spin_lock(&pool->lock);
+			if (nr_objs && !list_empty(&page->lru))
+				release_page(pool, page);
+			spin_unlock(&pool->lock);
+
+			put_page(page);
+			cond_resched();
+		}
+	} while (nr && !stop);
+
+	kfree(objs);
+
+	return moved;
+}
+EXPORT_SYMBOL_GPL(xv_compact);
@@ -15,8 +15,12 @@
 
 #include <linux/types.h>
 
+struct page;
 struct xv_pool;
 
+/* Histograms split [0, PAGE_SIZE] into this many equal ranges */
+#define XV_HIST_BUCKETS	8
+
 struct xv_pool *xv_create_pool(void);
 void xv_destroy_pool(struct xv_pool *pool);
 
@@ -26,5 +30,11 @@ void xv_free(struct xv_pool *pool, struct page *page, u32 offset);
 
 u32 xv_get_object_size(void *obj);
 u64 xv_get_total_size_bytes(struct xv_pool *pool);
+void xv_get_fill_histogram(struct xv_pool *pool, u32 *hist);
+void xv_get_size_histogram(struct xv_pool *pool, u32 *hist);
+
+int xv_compact(struct xv_pool *pool,
+		int (*migrate)(void *data, struct page *page, u32 offset),
+		void *data);
 
 #endif
@@ -15,6 +15,7 @@
 
 #include <linux/kernel.h>
 #include <linux/types.h>
+#include <linux/list.h>
 
 /* User configurable params */
 
@@ -48,6 +49,12 @@
 
 #define MAX_FLI		DIV_ROUND_UP(NUM_FREE_LISTS, BITS_PER_LONG)
 
+/* Pages with at most this many bytes in use are emptied by xv_compact() */
+#define XV_COMPACT_SPARSE	(PAGE_SIZE / 2)
+
+/* Number of sparse pages xv_compact() picks at a time */
+#define XV_COMPACT_BATCH	16
+
 /* End of user params */
 
 enum blockflags {
@@ -84,11 +91,21 @@ struct block_header {
 	struct link_free link;
 };
 
+/*
+ * Each pool page is on xv_pool->pages (through page->lru) and keeps
+ * the number of bytes allocated in it, headers included, in
+ * page->private.
+ */
 struct xv_pool {
 	ulong flbitmap;
 	ulong slbitmap[MAX_FLI];
 	u64 total_pages;	/* stats */
 	struct freelist_entry freelist[NUM_FREE_LISTS];
+	struct list_head pages;
+	struct page *isolated;	/* being emptied by xv_compact() */
+	u32 compact_seq;	/* xv_compact() pass, see page->index */
+	u32 fill_hist[XV_HIST_BUCKETS];	/* pages, by bytes in use */
+	u32 size_hist[XV_HIST_BUCKETS];	/* objects, by size */
 	spinlock_t lock;
 };
 
@@ -0,0 +1,293 @@
+/*
+ * Compressed RAM block device throughput benchmark
+ *
+ * This code is released using a dual license strategy: BSD/GPL
+ * You can choose the licence that better fits your requirements.
+ *
+ * Released under the terms of 3-clause BSD License
+ * Released under the terms of GNU General Public License Version 2.0
+ *
+ * Loading this module runs concurrent writers, then concurrent readers,
+ * against a zram device, and reports throughput and compression ratio:
+ *
+ *	modprobe zram_bench dev=/dev/zram0 writers=4 readers=4 size_kb=8192
+ *
+ * Everything previously stored on the device is overwritten. The module
+ * deliberately fails to load once the run is over, so that it can be
+ * loaded again straight away.
+ */
+
+#define KMSG_COMPONENT "zram_bench"
+#define pr_fmt(fmt) KMSG_COMPONENT ": " fmt
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/bio.h>
+#include <linux/blkdev.h>
+#include <linux/completion.h>
+#include <linux/fs.h>
+#include <linux/highmem.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+
+#include "zram_drv.h"
+
+/* Module params (documentation at end) */
+static char *dev = "/dev/zram0";
+static unsigned int writers;
+static unsigned int readers;
+static unsigned int size_kb = 4096;
+
+struct bench_thread {
+	struct block_device *bdev;
+	pgoff_t first;		/* first page handled by this thread */
+	pgoff_t nr_pages;
+	int rw;			/* READ or WRITE */
+	int errors;		/* failed I/Os and, for reads, bad data */
+	struct completion done;
+};
+
+/*
+ * Fill a page with data which compresses to roughly half its size
+ * with LZO: pseudo-random first half, repeated text for the rest.
+ * The content only depends on the page index so readers can check it.
+ */
+static void bench_fill_page(void *buf, pgoff_t index)
+{
+	static const char text[] = "zram benchmark: compressible text. ";
+	u32 *word = buf;
+	u32 seed = index * 2654435761U + 1;
+	unsigned int i;
+
+	for (i = 0; i < PAGE_SIZE / 2 / sizeof(*word); i++) {
+		seed = seed * 1103515245 + 12345;
+		word[i] = seed;
+	}
+
+	for (i = PAGE_SIZE / 2; i < PAGE_SIZE; i++)
+		((char *)buf)[i] = text[i % (sizeof(text) - 1)];
+}
+
+static void bench_end_io(struct bio *bio, int err)
+{
+	complete(bio->bi_private);
+}
+
+static int bench_rw_page(struct block_device *bdev, struct page *page,
+			pgoff_t index, int rw)
+{
+	DECLARE_COMPLETION_ONSTACK(done);
+	struct bio *bio;
+	int ret;
+
+	bio = bio_alloc(GFP_KERNEL, 1);
+	if (!bio)
+		return -ENOMEM;
+
+	bio->bi_bdev = bdev;
+	bio->bi_sector = index << SECTORS_PER_PAGE_SHIFT;
+	bio_add_page(bio, page, PAGE_SIZE, 0);
+	bio->bi_end_io = bench_end_io;
+	bio->bi_private = &done;
+
+	submit_bio(rw, bio);
+	wait_for_completion(&done);
+
+	ret = test_bit(BIO_UPTODATE, &bio->bi_flags) ? 0 : -EIO;
+	bio_put(bio);
+
+	return ret;
+}
+
+static int bench_thread_fn(void *data)
+{
+	struct bench_thread *t = data;
+	struct page *page;
+	void *expect = NULL;
+	pgoff_t index;
+
+	page = alloc_page(GFP_KERNEL);
+	if (t->rw == READ)
+		expect = kmalloc(PAGE_SIZE, GFP_KERNEL);
+	if (!page || (t->rw == READ && !expect)) {
+		t->errors = t->nr_pages;
+		goto out;
+	}
+
+	for (index = t->first; index < t->first + t->nr_pages; index++) {
+		void *mem;
+
+		if (t->rw == WRITE) {
+			mem = kmap(page);
+			bench_fill_page(mem, index);
+			kunmap(page);
+		}
+
+		if (bench_rw_page(t->bdev, page, index, t->rw)) {
+			t->errors++;
+			continue;
+		}
+
+		if (t->rw == READ) {
+			bench_fill_page(expect, index);
+			mem = kmap(page);
+			if (memcmp(mem, expect, PAGE_SIZE))
+				t->errors++;
+			kunmap(page);
+		}
+
+		cond_resched();
+	}
+
+out:
+	kfree(expect);
+	if (page)
+		__free_page(page);
+	complete_and_exit(&t->done, 0);
+}
+
+/*
+ * Split pages [0, nr_pages) between nr_threads threads doing rw, and
+ * return the time they took in microseconds, or a negative error.
+ */
+static s64 bench_run(struct block_device *bdev, int rw,
+		unsigned int nr_threads, pgoff_t nr_pages, int *errors)
+{
+	struct bench_thread *threads;
+	struct task_struct *tsk;
+	pgoff_t per_thread = nr_pages / nr_threads;
+	ktime_t start;
+	unsigned int i, started = 0;
+
+	threads = kcalloc(nr_threads, sizeof(*threads), GFP_KERNEL);
+	if (!threads)
+		return -ENOMEM;
+
+	start = ktime_get();
+	for (i = 0; i < nr_threads; i++) {
+		struct bench_thread *t = &threads[i];
+
+		t->bdev = bdev;
+		t->first = i * per_thread;
+		t->nr_pages = per_thread;
+		t->rw = rw;
+		init_completion(&t->done);
+
+		tsk = kthread_run(bench_thread_fn, t, "zram_bench/%u", i);
+		if (IS_ERR(tsk)) {
+			pr_err("Error starting thread %u\n", i);
+			break;
+		}
+		started++;
+	}
+
+	*errors = 0;
+	for (i = 0; i < started; i++) {
+		wait_for_completion(&threads[i].done);
+		*errors += threads[i].errors;
+	}
+	*errors += (nr_threads - started) * per_thread;
+
+	kfree(threads);
+
+	return ktime_us_delta(ktime_get(), start);
+}
+
+static void bench_report(const char *what, unsigned int nr_threads,
+		pgoff_t nr_pages, s64 us, int errors)
+{
+	u64 kb = (u64)nr_pages << (PAGE_SHIFT - 10);
+
+	if (us <= 0)
+		us = 1;
+
+	pr_info("%u %s: %llu kB in %lld us, %llu MB/s, %d errors\n",
+		nr_threads, what, kb, us,
+		div64_u64(kb * 1000000, (u64)us * 1024), errors);
+}
+
+static int __init zram_bench_init(void)
+{
+	struct block_device *bdev;
+	struct zram *zram = NULL;
+	pgoff_t nr_pages;
+	int errors;
+	s64 us;
+
+	if (!writers)
+		writers = num_online_cpus();
+	if (!readers)
+		readers = num_online_cpus();
+
+	bdev = blkdev_get_by_path(dev, FMODE_READ | FMODE_WRITE | FMODE_EXCL,
+				THIS_MODULE);
+	if (IS_ERR(bdev)) {
+		pr_err("Error opening %s: %ld\n", dev, PTR_ERR(bdev));
+		return PTR_ERR(bdev);
+	}
+
+	/* Writes initialize the device, which sets its size */
+	nr_pages = (pgoff_t)writers * (size_kb >> (PAGE_SHIFT - 10));
+	if (!strncmp(bdev->bd_disk->disk_name, "zram", 4)) {
+		zram = bdev->bd_disk->private_data;
+		if (zram->init_done || zram->disksize)
+			nr_pages = min_t(pgoff_t, nr_pages,
+					zram->disksize >> PAGE_SHIFT);
+	}
+
+	if (nr_pages < writers || nr_pages < readers) {
+		pr_err("%s is too small\n", dev);
+		goto out;
+	}
+
+	/* Only read back what has actually been written */
+	nr_pages -= nr_pages % writers;
+
+	us = bench_run(bdev, WRITE, writers, nr_pages, &errors);
+	if (us < 0)
+		goto out;
+	bench_report("writers", writers, nr_pages, us, errors);
+
+	nr_pages -= nr_pages % readers;
+
+	us = bench_run(bdev, READ, readers, nr_pages, &errors);
+	if (us < 0)
+		goto out;
+	bench_report("readers", readers, nr_pages, us, errors);
+
+	if (zram && zram->init_done) {
+		u64 orig, compr;
+
+		orig = (u64)atomic_read(&zram->stats.pages_stored)
+				<< PAGE_SHIFT;
+		spin_lock(&zram->stat64_lock);
+		compr = zram->stats.compr_size;
+		spin_unlock(&zram->stat64_lock);
+
+		pr_info("orig_data_size %llu, compr_data_size %llu, "
+			"ratio %llu%%\n", orig, compr,
+			compr ? div64_u64(orig * 100, compr) : 0);
+	}
+
+out:
+	blkdev_put(bdev, FMODE_READ | FMODE_WRITE | FMODE_EXCL);
+
+	/* Don't stay loaded: the benchmark is over */
+	return -EAGAIN;
+}
+
+module_param(dev, charp, 0);
+MODULE_PARM_DESC(dev, "Block device to benchmark (default /dev/zram0)");
+module_param(writers, uint, 0);
+MODULE_PARM_DESC(writers, "Number of concurrent writers (default: one per CPU)");
+module_param(readers, uint, 0);
+MODULE_PARM_DESC(readers, "Number of concurrent readers (default: one per CPU)");
+module_param(size_kb, uint, 0);
+MODULE_PARM_DESC(size_kb, "Data written by each writer, in kB");
+
+module_init(zram_bench_init);
+
+MODULE_LICENSE("Dual BSD/GPL");
+MODULE_DESCRIPTION("Compressed RAM Block Device benchmark");
@@ -28,8 +28,9 @@
 #include <linux/device.h>
 #include <linux/genhd.h>
 #include <linux/highmem.h>
+#include <linux/jhash.h>
+#include <linux/log2.h>
 #include <linux/slab.h>
-#include <linux/lzo.h>
 #include <linux/string.h>
 #include <linux/vmalloc.h>
 
@@ -42,14 +43,14 @@ struct zram *devices;
 /* Module params (documentation at end) */
 unsigned int num_devices;
 
-static void zram_stat_inc(u32 *v)
+static void zram_stat_inc(atomic_t *v)
 {
-	*v = *v + 1;
+	atomic_inc(v);
 }
 
-static void zram_stat_dec(u32 *v)
+static void zram_stat_dec(atomic_t *v)
 {
-	*v = *v - 1;
+	atomic_dec(v);
 }
 
 static void zram_stat64_add(struct zram *zram, u64 *v, u64 inc)
@@ -133,7 +134,122 @@ static void zram_set_disksize(struct zram *zram, size_t totalram_bytes)
 	zram->disksize &= PAGE_MASK;
 }
 
-static void zram_free_page(struct zram *zram, size_t index)
+static struct hlist_head *zram_dedup_bucket(struct zram *zram, u32 checksum)
+{
+	return &zram->dedup_table[checksum & zram->dedup_mask];
+}
+
+/*
+ * Look for an object identical to the freshly compressed page in src
+ * and, if there is one, make table entry 'index' share it.
+ * Identical pages compress identically, so comparing the compressed
+ * data is enough, and cheaper.
+ */
+static int zram_dedup_get(struct zram *zram, u32 index, void *src,
+			unsigned int clen, u32 checksum)
+{
+	int found = 0;
+	unsigned char *cmem;
+	struct zram_dedup *dup;
+	struct hlist_node *pos;
+
+	spin_lock(&zram->dedup_lock);
+	hlist_for_each_entry(dup, pos, zram_dedup_bucket(zram, checksum),
+			node) {
+		if (dup->checksum != checksum || dup->clen != clen ||
+				dup->refs == UINT_MAX)
+			continue;
+
+		cmem = kmap_atomic(dup->page, KM_USER1) + dup->offset;
+		found = !memcmp(cmem + sizeof(struct zobj_header), src, clen);
+		kunmap_atomic(cmem, KM_USER1);
+
+		if (found) {
+			dup->refs++;
+			zram->table[index].page = dup->page;
+			zram->table[index].offset = dup->offset;
+			zram->table[index].checksum = checksum;
+			zram_set_flag(zram, index, ZRAM_DEDUP);
+			break;
+		}
+	}
+	spin_unlock(&zram->dedup_lock);
+
+	return found;
+}
+
+/*
+ * Make the object just stored for table entry 'index' available for
+ * sharing. If we're short of memory, the object simply isn't shared.
+ */
+static void zram_dedup_add(struct zram *zram, u32 index,
+			unsigned int clen, u32 checksum)
+{
+	struct zram_dedup *dup;
+
+	dup = kmalloc(sizeof(*dup), GFP_NOIO);
+	if (!dup)
+		return;
+
+	dup->page = zram->table[index].page;
+	dup->offset = zram->table[index].offset;
+	dup->clen = clen;
+	dup->checksum = checksum;
+	dup->refs = 1;
+
+	spin_lock(&zram->dedup_lock);
+	hlist_add_head(&dup->node, zram_dedup_bucket(zram, checksum));
+	spin_unlock(&zram->dedup_lock);
+
+	zram->table[index].checksum = checksum;
+	zram_set_flag(zram, index, ZRAM_DEDUP);
+}
+
+/*
+ * Find the shareable object of table entry 'index'.
+ * Called with dedup_lock held.
+ */
+static struct zram_dedup *zram_dedup_find(struct zram *zram, u32 index)
+{
+	struct zram_dedup *dup;
+	struct hlist_node *pos;
+	struct table *entry = &zram->table[index];
+
+	hlist_for_each_entry(dup, pos,
+			zram_dedup_bucket(zram, entry->checksum), node) {
+		if (dup->page == entry->page && dup->offset == entry->offset)
+			return dup;
+	}
+
+	return NULL;
+}
+
+/*
+ * Drop table entry 'index''s reference to its shareable object.
+ * Returns nonzero if other entries still use it, in which case the
+ * object must not be freed.
+ */
+static int zram_dedup_put(struct zram *zram, u32 index)
+{
+	int shared = 0;
+	struct zram_dedup *dup;
+
+	spin_lock(&zram->dedup_lock);
+	dup = zram_dedup_find(zram, index);
+	if (dup) {
+		if (--dup->refs)
+			shared = 1;
+		else {
+			hlist_del(&dup->node);
+			kfree(dup);
+		}
+	}
+	spin_unlock(&zram->dedup_lock);
+
+	return shared;
+}
+
+static void __zram_free_page(struct zram *zram, size_t index)
 {
 	u32 clen;
 	void *obj;
@@ -165,18 +281,120 @@ static void zram_free_page(struct zram *zram, size_t index)
 	clen = xv_get_object_size(obj) - sizeof(struct zobj_header);
 	kunmap_atomic(obj, KM_USER0);
 
-	xv_free(zram->mem_pool, page, offset);
 	if (clen <= PAGE_SIZE / 2)
 		zram_stat_dec(&zram->stats.good_compress);
 
+	if (zram_test_flag(zram, index, ZRAM_DEDUP)) {
+		zram_clear_flag(zram, index, ZRAM_DEDUP);
+		if (zram_dedup_put(zram, index)) {
+			zram_stat64_sub(zram, &zram->stats.dedup_saved, clen);
+			goto out_shared;
+		}
+	}
+
+	xv_free(zram->mem_pool, page, offset);
+
 out:
 	zram_stat64_sub(zram, &zram->stats.compr_size, clen);
+out_shared:
 	zram_stat_dec(&zram->stats.pages_stored);
 
 	zram->table[index].page = NULL;
 	zram->table[index].offset = 0;
 }
 
+static void zram_free_page(struct zram *zram, size_t index)
+{
+	/* Frees can't sleep, see zram_slot_free_notify() */
+	read_lock(&zram->move_lock);
+	__zram_free_page(zram, index);
+	read_unlock(&zram->move_lock);
+}
+
+/*
+ * Take an idle compression stream, waiting for one if all of them are
+ * in use. There is one stream per online CPU at device init, so this
+ * only ever waits when there are more concurrent I/Os than CPUs.
+ */
+static struct zram_stream *zram_stream_get(struct zram *zram)
+{
+	struct zram_stream *strm;
+
+	for (;;) {
+		spin_lock(&zram->stream_lock);
+		if (!list_empty(&zram->idle_streams)) {
+			strm = list_first_entry(&zram->idle_streams,
+					struct zram_stream, list);
+			list_del(&strm->list);
+			spin_unlock(&zram->stream_lock);
+			return strm;
+		}
+		spin_unlock(&zram->stream_lock);
+
+		wait_event(zram->stream_wait,
+			!list_empty(&zram->idle_streams));
+	}
+}
+
+static void zram_stream_put(struct zram *zram, struct zram_stream *strm)
+{
+	spin_lock(&zram->stream_lock);
+	list_add(&strm->list, &zram->idle_streams);
+	spin_unlock(&zram->stream_lock);
+
+	wake_up(&zram->stream_wait);
+}
+
+static void zram_destroy_streams(struct zram *zram)
+{
+	struct zram_stream *strm, *tmp;
+
+	list_for_each_entry_safe(strm, tmp, &zram->idle_streams, list) {
+		list_del(&strm->list);
+		if (strm->tfm)
+			crypto_free_comp(strm->tfm);
+		free_pages((unsigned long)strm->buffer, 1);
+		kfree(strm);
+	}
+	zram->num_streams = 0;
+}
+
+static int zram_create_streams(struct zram *zram)
+{
+	int i, ret;
+	struct zram_stream *strm;
+
+	for (i = 0; i < num_online_cpus(); i++) {
+		strm = kzalloc(sizeof(*strm), GFP_KERNEL);
+		if (!strm)
+			return -ENOMEM;
+		list_add(&strm->list, &zram->idle_streams);
+		zram->num_streams++;
+
+		/*
+		 * The crypto API keeps per-transform state for some
+		 * algorithms (deflate's zlib streams, for example), so
+		 * each stream has a transform of its own.
+		 */
+		strm->tfm = crypto_alloc_comp(zram->comp_algorithm, 0, 0);
+		if (IS_ERR(strm->tfm)) {
+			pr_err("Error allocating %s compressor!\n",
+				zram->comp_algorithm);
+			ret = PTR_ERR(strm->tfm);
+			strm->tfm = NULL;
+			return ret;
+		}
+
+		strm->buffer = (void *)__get_free_pages(__GFP_ZERO, 1);
+		if (!strm->buffer) {
+			pr_err("Error allocating compressor buffer space\n");
+			return -ENOMEM;
+		}
+	}
+
+	return 0;
+}
+
 static void handle_zero_page(struct page *page)
 {
 	void *user_mem;
@@ -216,9 +434,10 @@ static void zram_read(struct zram *zram, struct bio *bio)
 
 	bio_for_each_segment(bvec, bio, i) {
 		int ret;
-		size_t clen;
+		unsigned int clen;
 		struct page *page;
 		struct zobj_header *zheader;
+		struct zram_stream *strm;
 		unsigned char *user_mem, *cmem;
 
 		page = bvec->bv_page;
@@ -245,13 +464,16 @@ static void zram_read(struct zram *zram, struct bio *bio)
 			continue;
 		}
 
+		/* Reads never take zram->lock, only an idle stream */
+		strm = zram_stream_get(zram);
+
 		user_mem = kmap_atomic(page, KM_USER0);
 		clen = PAGE_SIZE;
 
 		cmem = kmap_atomic(zram->table[index].page, KM_USER1) +
 				zram->table[index].offset;
 
-		ret = lzo1x_decompress_safe(
+		ret = crypto_comp_decompress(strm->tfm,
 			cmem + sizeof(*zheader),
 			xv_get_object_size(cmem) - sizeof(*zheader),
 			user_mem, &clen);
@@ -259,8 +481,10 @@ static void zram_read(struct zram *zram, struct bio *bio)
 		kunmap_atomic(user_mem, KM_USER0);
 		kunmap_atomic(cmem, KM_USER1);
 
+		zram_stream_put(zram, strm);
+
 		/* Should NEVER happen. Return bio error if it does. */
-		if (unlikely(ret != LZO_E_OK)) {
+		if (unlikely(ret || clen != PAGE_SIZE)) {
 			pr_err("Decompression failed! err=%d, page=%u\n",
 				ret, index);
 			zram_stat64_inc(zram, &zram->stats.failed_reads);
@@ -290,14 +514,14 @@ static void zram_write(struct zram *zram, struct bio *bio)
 
 	bio_for_each_segment(bvec, bio, i) {
 		int ret;
-		u32 offset;
-		size_t clen;
+		u32 offset, checksum = 0;
+		unsigned int clen;
 		struct zobj_header *zheader;
 		struct page *page, *page_store;
+		struct zram_stream *strm;
 		unsigned char *user_mem, *cmem, *src;
 
 		page = bvec->bv_page;
-		src = zram->compress_buffer;
 
 		/*
 		 * System overwrites unused sectors. Free memory associated
@@ -307,30 +531,50 @@ static void zram_write(struct zram *zram, struct bio *bio)
 				zram_test_flag(zram, index, ZRAM_ZERO))
 			zram_free_page(zram, index);
 
-		mutex_lock(&zram->lock);
-
 		user_mem = kmap_atomic(page, KM_USER0);
 		if (page_zero_filled(user_mem)) {
 			kunmap_atomic(user_mem, KM_USER0);
-			mutex_unlock(&zram->lock);
 			zram_stat_inc(&zram->stats.pages_zero);
 			zram_set_flag(zram, index, ZRAM_ZERO);
 			index++;
 			continue;
 		}
+		kunmap_atomic(user_mem, KM_USER0);
 
-		ret = lzo1x_1_compress(user_mem, PAGE_SIZE, src, &clen,
-					zram->compress_workmem);
+		/*
+		 * Compression runs in parallel on as many streams as there
+		 * are CPUs; only storing the result is serialized.
+		 */
+		strm = zram_stream_get(zram);
+		src = strm->buffer;
 
+		/* The stream buffer is two pages: room for any expansion */
+		clen = 2 * PAGE_SIZE;
+		user_mem = kmap_atomic(page, KM_USER0);
+		ret = crypto_comp_compress(strm->tfm, user_mem, PAGE_SIZE,
+					src, &clen);
 		kunmap_atomic(user_mem, KM_USER0);
 
-		if (unlikely(ret != LZO_E_OK)) {
-			mutex_unlock(&zram->lock);
+		if (unlikely(ret)) {
+			zram_stream_put(zram, strm);
 			pr_err("Compression failed! err=%d\n", ret);
 			zram_stat64_inc(zram, &zram->stats.failed_writes);
 			goto out;
 		}
 
+		mutex_lock(&zram->lock);
+
+		/* Share the object of an identical page, if there is one */
+		if (clen <= max_zpage_size) {
+			checksum = jhash(src, clen, 0);
+			if (zram_dedup_get(zram, index, src, clen, checksum)) {
+				zram_stat64_inc(zram, &zram->stats.dedup_hits);
+				zram_stat64_add(zram, &zram->stats.dedup_saved,
+						clen);
+				goto stored;
+			}
+		}
+
 		/*
 		 * Page is incompressible. Store it as-is (uncompressed)
 		 * since we do not want to return too many disk write
@@ -341,6 +585,7 @@ static void zram_write(struct zram *zram, struct bio *bio)
 			page_store = alloc_page(GFP_NOIO | __GFP_HIGHMEM);
 			if (unlikely(!page_store)) {
 				mutex_unlock(&zram->lock);
+				zram_stream_put(zram, strm);
 				pr_info("Error allocating memory for "
 					"incompressible page: %u\n", index);
 				zram_stat64_inc(zram,
@@ -360,8 +605,9 @@ static void zram_write(struct zram *zram, struct bio *bio)
 				&zram->table[index].page, &offset,
 				GFP_NOIO | __GFP_HIGHMEM)) {
 			mutex_unlock(&zram->lock);
+			zram_stream_put(zram, strm);
 			pr_info("Error allocating memory for compressed "
-				"page: %u, size=%zu\n", index, clen);
+				"page: %u, size=%u\n", index, clen);
 			zram_stat64_inc(zram, &zram->stats.failed_writes);
 			goto out;
 		}
@@ -372,28 +618,30 @@ memstore:
 		cmem = kmap_atomic(zram->table[index].page, KM_USER1) +
 				zram->table[index].offset;
 
-#if 0
 		/* Back-reference needed for memory defragmentation */
 		if (!zram_test_flag(zram, index, ZRAM_UNCOMPRESSED)) {
 			zheader = (struct zobj_header *)cmem;
 			zheader->table_idx = index;
 			cmem += sizeof(*zheader);
 		}
-#endif
 
 		memcpy(cmem, src, clen);
 
 		kunmap_atomic(cmem, KM_USER1);
 		if (unlikely(zram_test_flag(zram, index, ZRAM_UNCOMPRESSED)))
 			kunmap_atomic(src, KM_USER0);
+		else
+			zram_dedup_add(zram, index, clen, checksum);
 
 		/* Update stats */
 		zram_stat64_add(zram, &zram->stats.compr_size, clen);
+stored:
 		zram_stat_inc(&zram->stats.pages_stored);
 		if (clen <= PAGE_SIZE / 2)
 			zram_stat_inc(&zram->stats.good_compress);
 
 		mutex_unlock(&zram->lock);
+		zram_stream_put(zram, strm);
 		index++;
 	}
 
@@ -453,29 +701,150 @@ static int zram_make_request(struct request_queue *queue, struct bio *bio)
 	return 0;
 }
 
+/*
+ * Move the object at <page, offset> to another pool page, and point
+ * the table entry it belongs to there. Called by xv_compact().
+ */
+static int zram_migrate(void *data, struct page *page, u32 offset)
+{
+	int ret = -EBUSY;
+	u32 index, size, new_offset;
+	struct page *new_page;
+	struct zram *zram = data;
+	struct zram_dedup *dup = NULL;
+	unsigned char *obj, *new_obj;
+
+	write_lock(&zram->move_lock);
+
+	obj = kmap_atomic(page, KM_USER0) + offset;
+	index = ((struct zobj_header *)obj)->table_idx;
+	kunmap_atomic(obj, KM_USER0);
+
+	/*
+	 * The object may have been freed, and its header overwritten, since
+	 * xv_compact() found it. Its back-reference is only to be trusted
+	 * if that table entry still points to it.
+	 */
+	if (index >= zram->disksize >> PAGE_SHIFT ||
+			zram->table[index].page != page ||
+			zram->table[index].offset != offset ||
+			zram_test_flag(zram, index, ZRAM_UNCOMPRESSED))
+		goto out;
+
+	/* Objects used by several table entries stay where they are */
+	if (zram_test_flag(zram, index, ZRAM_DEDUP)) {
+		spin_lock(&zram->dedup_lock);
+		dup = zram_dedup_find(zram, index);
+		if (dup && dup->refs > 1)
+			goto out_dedup;
+	}
+
+	obj = kmap_atomic(page, KM_USER0) + offset;
+	size = xv_get_object_size(obj);
+	kunmap_atomic(obj, KM_USER0);
+
+	/* Only use free space of other pages: never grow the pool */
+	ret = xv_malloc(zram->mem_pool, size, &new_page, &new_offset,
+			GFP_NOWAIT);
+	if (ret)
+		goto out_dedup;
+
+	obj = kmap_atomic(page, KM_USER0) + offset;
+	new_obj = kmap_atomic(new_page, KM_USER1) + new_offset;
+	memcpy(new_obj, obj, size);
+	kunmap_atomic(new_obj, KM_USER1);
+	kunmap_atomic(obj, KM_USER0);
+
+	zram->table[index].page = new_page;
+	zram->table[index].offset = new_offset;
+	if (dup) {
+		dup->page = new_page;
+		dup->offset = new_offset;
+	}
+
+	xv_free(zram->mem_pool, page, offset);
+
+out_dedup:
+	if (zram_test_flag(zram, index, ZRAM_DEDUP))
+		spin_unlock(&zram->dedup_lock);
+out:
+	write_unlock(&zram->move_lock);
+
+	return ret;
+}
+
+/*
+ * Move objects out of sparsely used pages of the pool, so that these
+ * can be freed. Returns the number of objects moved.
+ *
+ * Holding every stream keeps reads and writes from looking up objects
+ * meanwhile; frees are kept off the object being moved by move_lock.
+ */
+int zram_compact(struct zram *zram)
+{
+	int i, ret = 0;
+	struct zram_stream *strm, *tmp;
+	LIST_HEAD(streams);
+
+	mutex_lock(&zram->init_lock);
+	if (!zram->init_done)
+		goto out;
+
+	for (i = 0; i < zram->num_streams; i++) {
+		strm = zram_stream_get(zram);
+		list_add(&strm->list, &streams);
+	}
+
+	ret = xv_compact(zram->mem_pool, zram_migrate, zram);
+
+	list_for_each_entry_safe(strm, tmp, &streams, list) {
+		list_del(&strm->list);
+		zram_stream_put(zram, strm);
+	}
+
+out:
+	mutex_unlock(&zram->init_lock);
+
+	return ret;
+}
+
 void zram_reset_device(struct zram *zram)
 {
 	size_t index;
+	struct zram_dedup *dup;
+	struct hlist_node *pos, *n;
 
 	mutex_lock(&zram->init_lock);
 	zram->init_done = 0;
 
 	/* Free various per-device buffers */
-	kfree(zram->compress_workmem);
-	free_pages((unsigned long)zram->compress_buffer, 1);
-
-	zram->compress_workmem = NULL;
-	zram->compress_buffer = NULL;
+	zram_destroy_streams(zram);
+
+	/* Free shareable objects once, rather than once per user */
+	for (index = 0; zram->dedup_table &&
+			index <= zram->dedup_mask; index++) {
+		hlist_for_each_entry_safe(dup, pos, n,
+				&zram->dedup_table[index], node) {
+			xv_free(zram->mem_pool, dup->page, dup->offset);
+			kfree(dup);
+		}
+	}
+	vfree(zram->dedup_table);
+	zram->dedup_table = NULL;
 
-	/* Free all pages that are still in this zram device */
-	for (index = 0; index < zram->disksize >> PAGE_SHIFT; index++) {
+	/*
+	 * Free all pages that are still in this zram device. The table
+	 * is missing if initialization failed before allocating it.
+	 */
+	for (index = 0; zram->table &&
+			index < zram->disksize >> PAGE_SHIFT; index++) {
 		struct page *page;
 		u16 offset;
 
 		page = zram->table[index].page;
 		offset = zram->table[index].offset;
 
-		if (!page)
+		if (!page || zram_test_flag(zram, index, ZRAM_DEDUP))
 			continue;
 
 		if (unlikely(zram_test_flag(zram, index, ZRAM_UNCOMPRESSED)))
@@ -511,19 +880,9 @@ int zram_init_device(struct zram *zram)
 
 	zram_set_disksize(zram, totalram_pages << PAGE_SHIFT);
 
-	zram->compress_workmem = kzalloc(LZO1X_MEM_COMPRESS, GFP_KERNEL);
-	if (!zram->compress_workmem) {
-		pr_err("Error allocating compressor working memory!\n");
-		ret = -ENOMEM;
-		goto fail;
-	}
-
-	zram->compress_buffer = (void *)__get_free_pages(__GFP_ZERO, 1);
-	if (!zram->compress_buffer) {
-		pr_err("Error allocating compressor buffer space\n");
-		ret = -ENOMEM;
+	ret = zram_create_streams(zram);
+	if (ret)
 		goto fail;
-	}
 
 	num_pages = zram->disksize >> PAGE_SHIFT;
 	zram->table = vzalloc(num_pages * sizeof(*zram->table));
@@ -535,6 +894,17 @@ int zram_init_device(struct zram *zram)
 		goto fail;
 	}
 
+	/* One bucket for every four pages keeps the chains short */
+	zram->dedup_mask =
+		roundup_pow_of_two(max_t(size_t, num_pages / 4, 1)) - 1;
+	zram->dedup_table = vzalloc((zram->dedup_mask + 1) *
+				sizeof(*zram->dedup_table));
+	if (!zram->dedup_table) {
+		pr_err("Error allocating zram dedup table\n");
+		ret = -ENOMEM;
+		goto fail;
+	}
+
 	set_capacity(zram->disk, zram->disksize >> SECTOR_SHIFT);
 
 	/* zram devices sort of resembles non-rotational disks */
@@ -582,6 +952,13 @@ static int create_device(struct zram *zram, int device_id)
 	mutex_init(&zram->lock);
 	mutex_init(&zram->init_lock);
 	spin_lock_init(&zram->stat64_lock);
+	spin_lock_init(&zram->stream_lock);
+	spin_lock_init(&zram->dedup_lock);
+	rwlock_init(&zram->move_lock);
+	INIT_LIST_HEAD(&zram->idle_streams);
+	init_waitqueue_head(&zram->stream_wait);
+	strlcpy(zram->comp_algorithm, default_comp_algorithm,
+		sizeof(zram->comp_algorithm));
 
 	zram->queue = blk_alloc_queue(GFP_KERNEL);
 	if (!zram->queue) {
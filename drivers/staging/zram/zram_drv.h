@@ -17,6 +17,9 @@
 
 #include <linux/spinlock.h>
 #include <linux/mutex.h>
+#include <linux/list.h>
+#include <linux/wait.h>
+#include <linux/crypto.h>
 
 #include "xvmalloc.h"
 
@@ -33,9 +36,7 @@ static const unsigned max_num_devices = 32;
  * object. This is required to support memory defragmentation.
  */
 struct zobj_header {
-#if 0
 	u32 table_idx;
-#endif
 };
 
 /*-- Configurable parameters */
@@ -43,6 +44,9 @@ struct zobj_header {
 /* Default zram disk size: 25% of total RAM */
 static const unsigned default_disksize_perc_ram = 25;
 
+/* Default compression algorithm (see /proc/crypto for the others) */
+static const char default_comp_algorithm[] = "lzo";
+
 /*
  * Pages that compress to size greater than this are stored
  * uncompressed in memory.
@@ -71,6 +75,9 @@ enum zram_pageflags {
 	/* Page consists entirely of zeros */
 	ZRAM_ZERO,
 
+	/* Object is shareable, tracked in zram->dedup_table */
+	ZRAM_DEDUP,
+
 	__NR_ZRAM_PAGEFLAGS,
 };
 
@@ -82,8 +89,23 @@ struct table {
 	u16 offset;
 	u8 count;	/* object ref count (not yet used) */
 	u8 flags;
+	u32 checksum;	/* of the compressed object, if ZRAM_DEDUP */
 } __attribute__((aligned(4)));
 
+/*
+ * One for each compressed object which may be shared by several table
+ * entries holding identical pages. The object is freed once the last
+ * of them lets go of it.
+ */
+struct zram_dedup {
+	struct hlist_node node;	/* in zram->dedup_table */
+	struct page *page;
+	u16 offset;
+	u16 clen;		/* compressed size */
+	u32 checksum;
+	u32 refs;		/* no. of table entries using the object */
+};
+
 struct zram_stats {
 	u64 compr_size;		/* compressed size of pages stored */
 	u64 num_reads;		/* failed + successful */
@@ -92,20 +114,36 @@ struct zram_stats {
 	u64 failed_writes;	/* can happen when memory is too low */
 	u64 invalid_io;		/* non-page-aligned I/O requests */
 	u64 notify_free;	/* no. of swap slot free notifications */
-	u32 pages_zero;		/* no. of zero filled pages */
-	u32 pages_stored;	/* no. of pages currently stored */
-	u32 good_compress;	/* % of pages with compression ratio<=50% */
-	u32 pages_expand;	/* % of incompressible pages */
+	u64 dedup_hits;		/* no. of pages stored by sharing an object */
+	u64 dedup_saved;	/* compressed bytes not stored thanks to that */
+	atomic_t pages_zero;	/* no. of zero filled pages */
+	atomic_t pages_stored;	/* no. of pages currently stored */
+	atomic_t good_compress;	/* % of pages with compression ratio<=50% */
+	atomic_t pages_expand;	/* % of incompressible pages */
+};
+
+/* Compressor state and output buffer, used by one I/O at a time */
+struct zram_stream {
+	struct crypto_comp *tfm;
+	void *buffer;		/* two pages, for compression output */
+	struct list_head list;	/* on zram->idle_streams when unused */
 };
 
 struct zram {
 	struct xv_pool *mem_pool;
-	void *compress_workmem;
-	void *compress_buffer;
 	struct table *table;
 	spinlock_t stat64_lock;	/* protect 64-bit stats */
-	struct mutex lock;	/* protect compression buffers against
+	struct mutex lock;	/* protect storing compressed pages against
 				 * concurrent writes */
+	struct list_head idle_streams;
+	spinlock_t stream_lock;	/* protect idle_streams */
+	wait_queue_head_t stream_wait;	/* for an idle stream */
+	int num_streams;
+	rwlock_t move_lock;	/* keep objects from being freed while
+				 * zram_compact() moves them */
+	struct hlist_head *dedup_table;	/* zram_dedup by checksum */
+	u32 dedup_mask;		/* no. of dedup_table buckets - 1 */
+	spinlock_t dedup_lock;	/* protect dedup_table and the refs */
 	struct request_queue *queue;
 	struct gendisk *disk;
 	int init_done;
@@ -116,6 +154,8 @@ struct zram {
 	 * we can store in a disk.
 	 */
 	u64 disksize;	/* bytes */
+	/* Crypto API compression algorithm used by this device */
+	char comp_algorithm[CRYPTO_MAX_ALG_NAME];
 
 	struct zram_stats stats;
 };
@@ -128,5 +168,6 @@ extern struct attribute_group zram_disk_attr_group;
 
 extern int zram_init_device(struct zram *zram);
 extern void zram_reset_device(struct zram *zram);
+extern int zram_compact(struct zram *zram);
 
 #endif
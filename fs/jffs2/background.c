@@ -21,6 +21,7 @@
 
 
 static int jffs2_garbage_collect_thread(void *);
+static int jffs2_garbage_collect_ahead(struct jffs2_sb_info *c);
 
 void jffs2_garbage_collect_trigger(struct jffs2_sb_info *c)
 {
@@ -146,7 +147,7 @@ static int jffs2_garbage_collect_thread(void *_c)
 		disallow_signal(SIGHUP);
 
 		D1(printk(KERN_DEBUG "jffs2_garbage_collect_thread(): pass\n"));
-		if (jffs2_garbage_collect_pass(c) == -ENOSPC) {
+		if (jffs2_garbage_collect_ahead(c) == -ENOSPC) {
 			printk(KERN_NOTICE "No space for garbage collection. Aborting GC thread\n");
 			goto die;
 		}
@@ -155,5 +156,33 @@ static int jffs2_garbage_collect_thread(void *_c)
 	spin_lock(&c->erase_completion_lock);
 	c->gc_task = NULL;
 	spin_unlock(&c->erase_completion_lock);
+	wake_up(&c->gc_wait);
 	complete_and_exit(&c->gc_thread_exit, 0);
 }
+
+/* Once free space is below resv_blocks_gcahead, don't take a nap after
+   every node: carry on until the whole eraseblock being collected has
+   been moved out of the way, so that writers find it ready for them
+   rather than having to collect it themselves. */
+static int jffs2_garbage_collect_ahead(struct jffs2_sb_info *c)
+{
+	int ret, more;
+
+	do {
+		ret = jffs2_garbage_collect_pass(c);
+
+		/* Let throttled writers re-check the free space */
+		wake_up(&c->gc_wait);
+		if (ret)
+			break;
+
+		spin_lock(&c->erase_completion_lock);
+		more = c->gcblock && !c->unchecked_size &&
+			c->nr_free_blocks + c->nr_erasing_blocks < c->resv_blocks_gcahead;
+		spin_unlock(&c->erase_completion_lock);
+
+		cond_resched();
+	} while (more && !signal_pending(current) && !kthread_should_stop());
+
+	return ret;
+}
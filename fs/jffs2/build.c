@@ -283,10 +283,16 @@ static void jffs2_calc_trigger_levels(struct jffs2_sb_info *c)
 
 	c->resv_blocks_write = c->resv_blocks_deletion + (size / c->sector_size);
 
-	/* When do we let the GC thread run in the background */
+	/* When do we make writers wait for the GC thread to catch up, rather
+	   than letting them run into the write reservation and have to
+	   garbage collect synchronously */
 
 	c->resv_blocks_gctrigger = c->resv_blocks_write + 1;
 
+	/* When do we let the GC thread run in the background, collecting
+	   whole eraseblocks ahead of the writers */
+	c->resv_blocks_gcahead = min(c->resv_blocks_gctrigger + 2, 255);
+
 	/* When do we allow garbage collection to merge nodes to make
 	   long-term progress at the expense of short-term space exhaustion? */
 	c->resv_blocks_gcmerge = c->resv_blocks_deletion + 1;
@@ -313,8 +319,10 @@ static void jffs2_calc_trigger_levels(struct jffs2_sb_info *c)
 		  c->resv_blocks_deletion, c->resv_blocks_deletion*c->sector_size/1024);
 	dbg_fsbuild("Blocks required to allow writes:      %d (%d KiB)\n",
 		  c->resv_blocks_write, c->resv_blocks_write*c->sector_size/1024);
-	dbg_fsbuild("Blocks required to quiesce GC thread: %d (%d KiB)\n",
+	dbg_fsbuild("Blocks required to stop throttling:   %d (%d KiB)\n",
 		  c->resv_blocks_gctrigger, c->resv_blocks_gctrigger*c->sector_size/1024);
+	dbg_fsbuild("Blocks required to quiesce GC thread: %d (%d KiB)\n",
+		  c->resv_blocks_gcahead, c->resv_blocks_gcahead*c->sector_size/1024);
 	dbg_fsbuild("Blocks required to allow GC merges:   %d (%d KiB)\n",
 		  c->resv_blocks_gcmerge, c->resv_blocks_gcmerge*c->sector_size/1024);
 	dbg_fsbuild("Blocks required to GC bad blocks:     %d (%d KiB)\n",
@@ -0,0 +1,760 @@
+/*
+ * JFFS2 -- Journalling Flash File System, Version 2.
+ *
+ * Mount-time checkpoint of the per-eraseblock summaries.
+ *
+ * For licensing information, see the file 'LICENCE' in this directory.
+ *
+ * A checkpoint is a copy of the summary records of every full eraseblock,
+ * written to a handful of free eraseblocks at unmount or sync time. When a
+ * valid checkpoint is found at mount, the summaries are replayed from it
+ * and only the blocks which may have been written since are scanned.
+ *
+ * The data in a full eraseblock can only change by erasing the block, so
+ * the checkpoint stays valid for as long as nothing has been erased. The
+ * anchor (first chunk) is therefore erased before any other eraseblock
+ * is, and a checkpoint whose anchor is still intact describes the medium.
+ * Blocks which were free or partially written when the checkpoint was
+ * taken are recorded as JFFS2_CKPT_SCAN and scanned as usual.
+ */
+
+#include <linux/kernel.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/mtd/mtd.h>
+#include <linux/crc32.h>
+#include <linux/wait.h>
+#include "nodelist.h"
+#include "debug.h"
+
+static inline uint32_t ckpt_chunk_ofs(struct jffs2_sb_info *c,
+				      struct jffs2_eraseblock *jeb)
+{
+	return jeb->offset + c->cleanmarker_size;
+}
+
+static inline uint32_t ckpt_chunk_max(struct jffs2_sb_info *c)
+{
+	return c->sector_size - c->cleanmarker_size -
+		sizeof(struct jffs2_raw_checkpoint);
+}
+
+static inline uint32_t ckpt_bufsize(struct jffs2_sb_info *c)
+{
+	return roundup(PAGE_SIZE, c->mtd->writesize);
+}
+
+static inline int ckpt_summarised(struct jffs2_sb_info *c,
+				  struct jffs2_eraseblock *jeb)
+{
+	return jeb->ckpt_sum && jeb != c->nextblock;
+}
+
+/* Keep the summary records of a full eraseblock - called from summary.c
+   both when a summary is scanned at mount and when one is written */
+void jffs2_ckpt_keep_summary(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
+			     uint32_t sumsize, uint32_t cln_mkr, uint32_t sum_num,
+			     void *rec, uint32_t reclen)
+{
+	struct jffs2_ckpt_sum *cs;
+
+	cs = kmalloc(sizeof(*cs) + reclen, GFP_KERNEL);
+	if (!cs) {
+		/* Non-fatal, the block will just be scanned */
+		dbg_ckpt("no memory to keep summary of 0x%08x\n", jeb->offset);
+		return;
+	}
+
+	cs->sumsize = sumsize;
+	cs->cln_mkr = cln_mkr;
+	cs->sum_num = sum_num;
+	cs->reclen = reclen;
+	memcpy(cs->rec, rec, reclen);
+
+	kfree(jeb->ckpt_sum);
+	jeb->ckpt_sum = cs;
+}
+
+void jffs2_ckpt_forget(struct jffs2_eraseblock *jeb)
+{
+	kfree(jeb->ckpt_sum);
+	jeb->ckpt_sum = NULL;
+}
+
+static int jffs2_ckpt_check_hdr(struct jffs2_sb_info *c,
+				struct jffs2_raw_checkpoint *ck)
+{
+	uint32_t crc;
+
+	if (je16_to_cpu(ck->magic) != JFFS2_MAGIC_BITMASK ||
+	    je16_to_cpu(ck->nodetype) != JFFS2_NODETYPE_CHECKPOINT)
+		return 0;
+
+	crc = crc32(0, ck, sizeof(struct jffs2_unknown_node) - 4);
+	if (je32_to_cpu(ck->hdr_crc) != crc)
+		return 0;
+
+	crc = crc32(0, ck, sizeof(*ck) - 4);
+	if (je32_to_cpu(ck->node_crc) != crc) {
+		dbg_ckpt("checkpoint node header is corrupt (bad CRC)\n");
+		return 0;
+	}
+
+	if (je32_to_cpu(ck->sector_size) != c->sector_size ||
+	    je32_to_cpu(ck->nr_blocks) != c->nr_blocks ||
+	    je32_to_cpu(ck->cln_mkr) != c->cleanmarker_size) {
+		dbg_ckpt("checkpoint was taken with a different geometry\n");
+		return 0;
+	}
+
+	if (je32_to_cpu(ck->len) > ckpt_chunk_max(c) ||
+	    je16_to_cpu(ck->index) >= je16_to_cpu(ck->count))
+		return 0;
+
+	return 1;
+}
+
+static void jffs2_ckpt_fill_hdr(struct jffs2_sb_info *c,
+				struct jffs2_raw_checkpoint *ck, uint32_t seq,
+				int index, int count, unsigned char *data,
+				uint32_t len)
+{
+	memset(ck, 0, sizeof(*ck));
+
+	ck->magic = cpu_to_je16(JFFS2_MAGIC_BITMASK);
+	ck->nodetype = cpu_to_je16(JFFS2_NODETYPE_CHECKPOINT);
+	ck->totlen = cpu_to_je32(c->sector_size - c->cleanmarker_size);
+	ck->hdr_crc = cpu_to_je32(crc32(0, ck, sizeof(struct jffs2_unknown_node) - 4));
+	ck->seq = cpu_to_je32(seq);
+	ck->index = cpu_to_je16(index);
+	ck->count = cpu_to_je16(count);
+	ck->sector_size = cpu_to_je32(c->sector_size);
+	ck->nr_blocks = cpu_to_je32(c->nr_blocks);
+	ck->cln_mkr = cpu_to_je32(c->cleanmarker_size);
+	ck->len = cpu_to_je32(len);
+	ck->data_crc = cpu_to_je32(crc32(0, data, len));
+	ck->node_crc = cpu_to_je32(crc32(0, ck, sizeof(*ck) - 4));
+}
+
+/* Read through a kmalloc'ed bounce buffer; the checkpoint itself is
+   vmalloc'ed and may not be suitable for the MTD driver to DMA into */
+static int jffs2_ckpt_read(struct jffs2_sb_info *c, uint32_t ofs, uint32_t len,
+			   unsigned char *dst, unsigned char *buf)
+{
+	uint32_t bufsize = ckpt_bufsize(c);
+	size_t retlen;
+	uint32_t n;
+	int ret;
+
+	while (len) {
+		n = min(len, bufsize);
+		ret = jffs2_flash_read(c, ofs, n, &retlen, buf);
+		if (ret)
+			return ret;
+		if (retlen != n)
+			return -EIO;
+		memcpy(dst, buf, n);
+		ofs += n;
+		dst += n;
+		len -= n;
+	}
+	return 0;
+}
+
+static int jffs2_ckpt_read_chunk(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
+				 struct jffs2_raw_checkpoint *ck, unsigned char *dst,
+				 unsigned char *buf)
+{
+	uint32_t len = je32_to_cpu(ck->len);
+	int ret;
+
+	ret = jffs2_ckpt_read(c, ckpt_chunk_ofs(c, jeb) + sizeof(*ck), len, dst, buf);
+	if (ret)
+		return ret;
+
+	if (je32_to_cpu(ck->data_crc) != crc32(0, dst, len)) {
+		JFFS2_WARNING("checkpoint chunk at 0x%08x is corrupt (bad CRC)\n",
+			      jeb->offset);
+		return -EBADMSG;
+	}
+	return 0;
+}
+
+/* Check that the table describes the medium consistently */
+static int jffs2_ckpt_check_table(struct jffs2_sb_info *c, unsigned char *data,
+				  uint32_t len, int count)
+{
+	struct jffs2_ckpt_entry *ent;
+	jint32_t *blocks = (jint32_t *)data;
+	uint32_t pos, blk, reclen, sumsize;
+	int i;
+
+	pos = count * sizeof(jint32_t) + c->nr_blocks * sizeof(*ent);
+	if (pos > len)
+		return 0;
+	ent = (struct jffs2_ckpt_entry *)(data + count * sizeof(jint32_t));
+
+	for (i = 0; i < count; i++) {
+		blk = je32_to_cpu(blocks[i]);
+		if (blk >= c->nr_blocks ||
+		    je32_to_cpu(ent[blk].state) != JFFS2_CKPT_SELF)
+			return 0;
+	}
+
+	for (i = 0; i < c->nr_blocks; i++) {
+		switch (je32_to_cpu(ent[i].state)) {
+		case JFFS2_CKPT_SCAN:
+		case JFFS2_CKPT_SELF:
+			break;
+
+		case JFFS2_CKPT_SUMMARY:
+			reclen = je32_to_cpu(ent[i].reclen);
+			sumsize = je32_to_cpu(ent[i].sumsize);
+			if (sumsize > c->sector_size || reclen > sumsize ||
+			    PAD(reclen) > len - pos)
+				return 0;
+			pos += PAD(reclen);
+			break;
+
+		default:
+			return 0;
+		}
+	}
+	return pos == len;
+}
+
+/* Look for a checkpoint at mount - called from jffs2_scan_medium() */
+int jffs2_ckpt_load(struct jffs2_sb_info *c)
+{
+	struct jffs2_raw_checkpoint ck, best;
+	struct jffs2_eraseblock *jeb, *anchor = NULL;
+	unsigned char *data = NULL, *buf = NULL;
+	uint32_t len, blk;
+	jint32_t *blocks;
+	size_t retlen;
+	int i, n, count, ret;
+
+	c->ckpt_anchor = NULL;
+	c->ckpt_data = NULL;
+
+	n = min_t(uint32_t, c->nr_blocks, JFFS2_CKPT_ANCHOR_BLOCKS);
+	for (i = 0; i < n; i++) {
+		jeb = &c->blocks[i];
+
+		if (jffs2_cleanmarker_oob(c) &&
+		    c->mtd->block_isbad(c->mtd, jeb->offset))
+			continue;
+
+		ret = jffs2_flash_read(c, ckpt_chunk_ofs(c, jeb), sizeof(ck),
+				       &retlen, (unsigned char *)&ck);
+		if (ret || retlen != sizeof(ck))
+			continue;
+
+		if (!jffs2_ckpt_check_hdr(c, &ck) || je16_to_cpu(ck.index))
+			continue;
+
+		if (anchor && je32_to_cpu(ck.seq) <= je32_to_cpu(best.seq))
+			continue;
+
+		anchor = jeb;
+		best = ck;
+	}
+
+	if (!anchor)
+		return 0;
+
+	/* Even if it turns out to be unusable, it has to be erased before
+	   anything else is, and the next one must have a higher number */
+	c->ckpt_anchor = anchor;
+	c->ckpt_seq = je32_to_cpu(best.seq);
+	count = je16_to_cpu(best.count);
+
+	dbg_ckpt("checkpoint %u found at 0x%08x (%d chunks)\n",
+		 c->ckpt_seq, anchor->offset, count);
+
+	if (count > c->nr_blocks ||
+	    je32_to_cpu(best.len) < count * sizeof(jint32_t))
+		goto bad;
+
+	buf = kmalloc(ckpt_bufsize(c), GFP_KERNEL);
+	data = vmalloc(count * ckpt_chunk_max(c));
+	if (!buf || !data) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	ret = jffs2_ckpt_read_chunk(c, anchor, &best, data, buf);
+	if (ret == -EBADMSG)
+		goto bad;
+	if (ret)
+		goto out;
+
+	blocks = (jint32_t *)data;
+	if (je32_to_cpu(blocks[0]) != anchor - c->blocks)
+		goto bad;
+
+	len = je32_to_cpu(best.len);
+	for (i = 1; i < count; i++) {
+		blk = je32_to_cpu(blocks[i]);
+		if (blk >= c->nr_blocks)
+			goto bad;
+		jeb = &c->blocks[blk];
+
+		ret = jffs2_flash_read(c, ckpt_chunk_ofs(c, jeb), sizeof(ck),
+				       &retlen, (unsigned char *)&ck);
+		if (ret)
+			goto out;
+		if (retlen != sizeof(ck) || !jffs2_ckpt_check_hdr(c, &ck) ||
+		    je32_to_cpu(ck.seq) != c->ckpt_seq ||
+		    je16_to_cpu(ck.index) != i ||
+		    je16_to_cpu(ck.count) != count)
+			goto bad;
+
+		ret = jffs2_ckpt_read_chunk(c, jeb, &ck, data + len, buf);
+		if (ret == -EBADMSG)
+			goto bad;
+		if (ret)
+			goto out;
+		len += je32_to_cpu(ck.len);
+	}
+
+	if (!jffs2_ckpt_check_table(c, data, len, count))
+		goto bad;
+
+	c->ckpt_data = data;
+	c->ckpt_ent = (struct jffs2_ckpt_entry *)(data + count * sizeof(jint32_t));
+	c->ckpt_pos = count * sizeof(jint32_t) +
+		c->nr_blocks * sizeof(struct jffs2_ckpt_entry);
+	c->ckpt_replayed = 0;
+	kfree(buf);
+	return 0;
+
+ bad:
+	JFFS2_NOTICE("checkpoint %u at 0x%08x is not usable, scanning the whole medium\n",
+		     c->ckpt_seq, anchor->offset);
+	ret = 0;
+ out:
+	vfree(data);
+	kfree(buf);
+	return ret;
+}
+
+/* Replay one eraseblock from the checkpoint - called from jffs2_scan_medium().
+   Returns a BLK_STATE_xxx, or zero if the block has to be scanned. */
+int jffs2_ckpt_scan_eraseblock(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
+			       uint32_t *pseudo_random)
+{
+	struct jffs2_ckpt_entry *ent;
+	unsigned char *rec;
+	int ret;
+
+	if (!c->ckpt_data)
+		return 0;
+
+	ent = &c->ckpt_ent[jeb - c->blocks];
+
+	switch (je32_to_cpu(ent->state)) {
+	case JFFS2_CKPT_SUMMARY:
+		rec = c->ckpt_data + c->ckpt_pos;
+		c->ckpt_pos += PAD(je32_to_cpu(ent->reclen));
+
+		ret = jffs2_sum_scan_records(c, jeb, je32_to_cpu(ent->sumsize),
+					     je32_to_cpu(ent->cln_mkr),
+					     je32_to_cpu(ent->sum_num), rec,
+					     pseudo_random);
+		if (ret > 0)
+			c->ckpt_replayed++;
+		return ret;
+
+	case JFFS2_CKPT_SELF:
+		ret = jffs2_prealloc_raw_node_refs(c, jeb, 1);
+		if (ret)
+			return ret;
+		ret = jffs2_scan_dirty_space(c, jeb, jeb->free_size);
+		if (ret)
+			return ret;
+		c->ckpt_replayed++;
+		/* All dirty, but keep it off the erase_pending_list: the
+		   checkpoint stays valid until the first erase */
+		return BLK_STATE_PARTDIRTY;
+	}
+
+	return 0;
+}
+
+void jffs2_ckpt_scan_done(struct jffs2_sb_info *c)
+{
+	if (!c->ckpt_data)
+		return;
+
+	JFFS2_NOTICE("mounted from checkpoint %u, scanned %u of %u eraseblocks\n",
+		     c->ckpt_seq, c->nr_blocks - c->ckpt_replayed, c->nr_blocks);
+
+	/* Until something is written, the checkpoint on flash is current */
+	c->ckpt_nextblock = c->nextblock;
+	c->ckpt_next_free = c->nextblock ? c->nextblock->free_size : 0;
+
+	vfree(c->ckpt_data);
+	c->ckpt_data = NULL;
+	c->ckpt_ent = NULL;
+}
+
+static void jffs2_ckpt_erase_callback(struct erase_info *instr)
+{
+	wake_up((wait_queue_head_t *)instr->priv);
+}
+
+/* Erase the anchor and wait for it, whatever the MTD driver does */
+static int jffs2_ckpt_erase_anchor(struct jffs2_sb_info *c,
+				   struct jffs2_eraseblock *jeb)
+{
+	DECLARE_WAIT_QUEUE_HEAD_ONSTACK(wq);
+	struct erase_info instr;
+	int ret;
+
+	memset(&instr, 0, sizeof(instr));
+	instr.mtd = c->mtd;
+	instr.addr = jeb->offset;
+	instr.len = c->sector_size;
+	instr.callback = jffs2_ckpt_erase_callback;
+	instr.priv = (unsigned long)&wq;
+	instr.fail_addr = MTD_FAIL_ADDR_UNKNOWN;
+
+	ret = c->mtd->erase(c->mtd, &instr);
+	if (ret)
+		return ret;
+
+	wait_event(wq, instr.state == MTD_ERASE_DONE ||
+		       instr.state == MTD_ERASE_FAILED);
+
+	return instr.state == MTD_ERASE_DONE ? 0 : -EIO;
+}
+
+/* The anchor could not be erased. Make sure no later mount finds it:
+   NAND bad blocks are skipped, and NOR can still program the node header
+   to zeros. Then take the block off the usable lists, as
+   jffs2_erase_failed() does, rather than failing to erase it forever. */
+static void jffs2_ckpt_retire_anchor(struct jffs2_sb_info *c,
+				     struct jffs2_eraseblock *jeb)
+{
+	struct jffs2_unknown_node node;
+	struct jffs2_eraseblock *p;
+	size_t retlen;
+	int ret;
+
+	if (jffs2_cleanmarker_oob(c)) {
+		ret = c->mtd->block_markbad(c->mtd, jeb->offset);
+	} else {
+		memset(&node, 0, sizeof(node));
+		ret = jffs2_flash_direct_write(c, ckpt_chunk_ofs(c, jeb),
+					       sizeof(node), &retlen,
+					       (unsigned char *)&node);
+		if (!ret && retlen != sizeof(node))
+			ret = -EIO;
+	}
+	if (ret)
+		JFFS2_ERROR("could not destroy checkpoint at 0x%08x: %d\n",
+			    jeb->offset, ret);
+
+	spin_lock(&c->erase_completion_lock);
+	/* Either is only possible if it has been fully garbage collected;
+	   it then gets erased, and retired, in the normal way */
+	if (jeb == c->gcblock || jeb == c->nextblock) {
+		spin_unlock(&c->erase_completion_lock);
+		return;
+	}
+	list_for_each_entry(p, &c->erase_pending_list, list) {
+		if (p == jeb) {
+			c->nr_erasing_blocks--;
+			break;
+		}
+	}
+	c->free_size -= jeb->free_size;
+	c->used_size -= jeb->used_size;
+	c->dirty_size -= jeb->dirty_size;
+	c->wasted_size -= jeb->wasted_size;
+	c->unchecked_size -= jeb->unchecked_size;
+	jeb->free_size = jeb->used_size = jeb->dirty_size = 0;
+	jeb->wasted_size = jeb->unchecked_size = 0;
+	jffs2_free_jeb_node_refs(c, jeb);
+	c->bad_size += c->sector_size;
+	list_move(&jeb->list, &c->bad_list);
+	spin_unlock(&c->erase_completion_lock);
+
+	JFFS2_WARNING("eraseblock 0x%08x retired\n", jeb->offset);
+}
+
+/* Destroy the checkpoint on flash. Must be called with erase_free_sem
+   held, before any eraseblock is erased. Never fails: an anchor that
+   cannot be erased is retired, and the next mount does a full scan. */
+void jffs2_ckpt_invalidate(struct jffs2_sb_info *c)
+{
+	struct jffs2_eraseblock *jeb = c->ckpt_anchor;
+	int ret;
+
+	if (!jeb)
+		return;
+
+	dbg_ckpt("invalidating checkpoint %u at 0x%08x\n",
+		 c->ckpt_seq, jeb->offset);
+
+	/* The block itself is still accounted as dirty space and will be
+	   erased again in the normal way; this only kills the anchor */
+	ret = jffs2_ckpt_erase_anchor(c, jeb);
+	if (ret) {
+		JFFS2_WARNING("erase of checkpoint at 0x%08x failed: %d\n",
+			      jeb->offset, ret);
+		jffs2_ckpt_retire_anchor(c, jeb);
+	}
+
+	c->ckpt_anchor = NULL;
+}
+
+/* Write one chunk, header first, through the bounce buffer */
+static int jffs2_ckpt_write_chunk(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
+				  struct jffs2_raw_checkpoint *ck, unsigned char *data,
+				  unsigned char *buf)
+{
+	uint32_t bufsize = ckpt_bufsize(c);
+	uint32_t ofs = ckpt_chunk_ofs(c, jeb);
+	uint32_t len = sizeof(*ck) + je32_to_cpu(ck->len);
+	uint32_t done, n, h, wlen;
+	size_t retlen;
+	int ret;
+
+	for (done = 0; done < len; done += n) {
+		n = min(len - done, bufsize);
+		h = 0;
+		if (done < sizeof(*ck)) {
+			h = min_t(uint32_t, n, sizeof(*ck) - done);
+			memcpy(buf, (unsigned char *)ck + done, h);
+		}
+		memcpy(buf + h, data + done + h - sizeof(*ck), n - h);
+
+		wlen = roundup(n, c->mtd->writesize);
+		memset(buf + n, 0xff, wlen - n);
+
+		ret = c->mtd->write(c->mtd, ofs + done, wlen, &retlen, buf);
+		if (ret || retlen != wlen) {
+			JFFS2_WARNING("write of checkpoint at 0x%08x failed: %d, retlen %zd\n",
+				      ofs + done, ret, retlen);
+			return ret ? ret : -EIO;
+		}
+	}
+	return 0;
+}
+
+/* Pick the eraseblocks for a checkpoint off the free_list. The anchor has
+   to be among the first JFFS2_CKPT_ANCHOR_BLOCKS. */
+static int jffs2_ckpt_grab_blocks(struct jffs2_sb_info *c,
+				  struct jffs2_eraseblock **jebs, int count)
+{
+	struct jffs2_eraseblock *jeb;
+	int n = 0;
+
+	if (c->nr_free_blocks < count + c->resv_blocks_write)
+		return -ENOSPC;
+
+	list_for_each_entry(jeb, &c->free_list, list) {
+		if (jeb - c->blocks < JFFS2_CKPT_ANCHOR_BLOCKS &&
+		    jeb->free_size == c->sector_size - c->cleanmarker_size) {
+			jebs[n++] = jeb;
+			break;
+		}
+	}
+	if (!n)
+		return -ENOSPC;
+
+	list_for_each_entry(jeb, &c->free_list, list) {
+		if (n == count)
+			break;
+		if (jeb != jebs[0] &&
+		    jeb->free_size == c->sector_size - c->cleanmarker_size)
+			jebs[n++] = jeb;
+	}
+	if (n < count)
+		return -ENOSPC;
+
+	for (n = 0; n < count; n++) {
+		list_del(&jebs[n]->list);
+		c->nr_free_blocks--;
+	}
+	return 0;
+}
+
+static void jffs2_ckpt_return_blocks(struct jffs2_sb_info *c,
+				     struct jffs2_eraseblock **jebs, int count)
+{
+	int n;
+
+	spin_lock(&c->erase_completion_lock);
+	for (n = 0; n < count; n++) {
+		list_add(&jebs[n]->list, &c->free_list);
+		c->nr_free_blocks++;
+	}
+	spin_unlock(&c->erase_completion_lock);
+}
+
+/* The chunks are garbage as far as the rest of JFFS2 is concerned */
+static void jffs2_ckpt_file_block(struct jffs2_sb_info *c,
+				  struct jffs2_eraseblock *jeb)
+{
+	struct jffs2_raw_node_ref *ref = jeb->first_node;
+	uint32_t len;
+
+	/* Forget the clean marker too, so that GC doesn't try to obsolete
+	   it on flash after the anchor has been erased underneath it */
+	if (ref && !ref_obsolete(ref)) {
+		len = c->sector_size - jeb->free_size;
+		ref->flash_offset = ref_offset(ref) | REF_OBSOLETE;
+		jeb->used_size -= len;
+		c->used_size -= len;
+		jeb->dirty_size += len;
+		c->dirty_size += len;
+	}
+	jffs2_scan_dirty_space(c, jeb, jeb->free_size);
+	list_add_tail(&jeb->list, &c->very_dirty_list);
+}
+
+/* Write a checkpoint - called at unmount and sync time */
+int jffs2_ckpt_write(struct jffs2_sb_info *c)
+{
+	struct jffs2_eraseblock *jeb, **jebs = NULL;
+	struct jffs2_ckpt_entry *ent;
+	struct jffs2_raw_checkpoint ck;
+	unsigned char *data = NULL, *buf = NULL, *rec;
+	uint32_t reclen, tablen, max, len, pos;
+	jint32_t *blocks;
+	int i, k, count, ret = 0;
+
+	if (c->cleanmarker_size % c->mtd->writesize)
+		return 0;
+
+	mutex_lock(&c->alloc_sem);
+	jffs2_flush_wbuf_pad(c);
+	/* No erase may start until the checkpoint is on flash */
+	mutex_lock(&c->erase_free_sem);
+
+	if (jffs2_ckpt_live(c) && c->ckpt_nextblock == c->nextblock &&
+	    (!c->nextblock || c->ckpt_next_free == c->nextblock->free_size)) {
+		dbg_ckpt("nothing written since checkpoint %u\n", c->ckpt_seq);
+		goto out;
+	}
+
+	jffs2_ckpt_invalidate(c);
+
+	reclen = 0;
+	spin_lock(&c->erase_completion_lock);
+	for (i = 0; i < c->nr_blocks; i++) {
+		jeb = &c->blocks[i];
+		if (ckpt_summarised(c, jeb))
+			reclen += PAD(jeb->ckpt_sum->reclen);
+	}
+	spin_unlock(&c->erase_completion_lock);
+
+	tablen = c->nr_blocks * sizeof(struct jffs2_ckpt_entry);
+	max = ckpt_chunk_max(c);
+	count = DIV_ROUND_UP(tablen + reclen, max);
+	if (count * sizeof(jint32_t) + tablen + reclen > count * max)
+		count++;
+	if (count * sizeof(jint32_t) > max) {
+		JFFS2_WARNING("checkpoint would take %d eraseblocks, not writing it\n",
+			      count);
+		goto out;
+	}
+
+	len = count * sizeof(jint32_t) + tablen + reclen;
+	data = vmalloc(len);
+	buf = kmalloc(ckpt_bufsize(c), GFP_KERNEL);
+	jebs = kmalloc(count * sizeof(*jebs), GFP_KERNEL);
+	if (!data || !buf || !jebs) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	blocks = (jint32_t *)data;
+	ent = (struct jffs2_ckpt_entry *)(data + count * sizeof(jint32_t));
+	rec = (unsigned char *)(ent + c->nr_blocks);
+
+	spin_lock(&c->erase_completion_lock);
+
+	ret = jffs2_ckpt_grab_blocks(c, jebs, count);
+	if (ret) {
+		spin_unlock(&c->erase_completion_lock);
+		dbg_ckpt("not enough free eraseblocks for a checkpoint\n");
+		ret = 0;
+		goto out;
+	}
+
+	/* alloc_sem is held, so summaries can only have gone away since
+	   they were counted, not appeared */
+	pos = 0;
+	for (i = 0; i < c->nr_blocks; i++) {
+		struct jffs2_ckpt_sum *cs = c->blocks[i].ckpt_sum;
+
+		memset(&ent[i], 0, sizeof(ent[i]));
+		ent[i].state = cpu_to_je32(JFFS2_CKPT_SCAN);
+		if (!ckpt_summarised(c, &c->blocks[i]) ||
+		    pos + PAD(cs->reclen) > reclen)
+			continue;
+
+		ent[i].state = cpu_to_je32(JFFS2_CKPT_SUMMARY);
+		ent[i].sumsize = cpu_to_je32(cs->sumsize);
+		ent[i].cln_mkr = cpu_to_je32(cs->cln_mkr);
+		ent[i].sum_num = cpu_to_je32(cs->sum_num);
+		ent[i].reclen = cpu_to_je32(cs->reclen);
+		memcpy(rec + pos, cs->rec, cs->reclen);
+		memset(rec + pos + cs->reclen, 0xff, PAD(cs->reclen) - cs->reclen);
+		pos += PAD(cs->reclen);
+	}
+	for (k = 0; k < count; k++) {
+		blocks[k] = cpu_to_je32(jebs[k] - c->blocks);
+		ent[jebs[k] - c->blocks].state = cpu_to_je32(JFFS2_CKPT_SELF);
+	}
+
+	c->ckpt_nextblock = c->nextblock;
+	c->ckpt_next_free = c->nextblock ? c->nextblock->free_size : 0;
+
+	spin_unlock(&c->erase_completion_lock);
+
+	for (k = 0; k < count; k++) {
+		ret = jffs2_prealloc_raw_node_refs(c, jebs[k], 1);
+		if (ret) {
+			jffs2_ckpt_return_blocks(c, jebs, count);
+			goto out;
+		}
+	}
+
+	len = count * sizeof(jint32_t) + tablen + pos;
+	c->ckpt_seq++;
+
+	/* Continuation chunks first; the anchor makes the checkpoint valid */
+	for (k = count - 1; k >= 0; k--) {
+		uint32_t ofs = k * max;
+		uint32_t clen = min(len - ofs, max);
+
+		if (!k)
+			c->ckpt_anchor = jebs[0];
+		jffs2_ckpt_fill_hdr(c, &ck, c->ckpt_seq, k, count, data + ofs, clen);
+		ret = jffs2_ckpt_write_chunk(c, jebs[k], &ck, data + ofs, buf);
+		if (ret)
+			break;
+	}
+
+	spin_lock(&c->erase_completion_lock);
+	for (k = 0; k < count; k++)
+		jffs2_ckpt_file_block(c, jebs[k]);
+	spin_unlock(&c->erase_completion_lock);
+
+	if (!ret)
+		dbg_ckpt("checkpoint %u written at 0x%08x (%u bytes, %d chunks)\n",
+			 c->ckpt_seq, jebs[0]->offset, len, count);
+ out:
+	mutex_unlock(&c->erase_free_sem);
+	mutex_unlock(&c->alloc_sem);
+	kfree(jebs);
+	kfree(buf);
+	vfree(data);
+	return ret;
+}
@@ -0,0 +1,74 @@
+/*
+ * JFFS2 -- Journalling Flash File System, Version 2.
+ *
+ * Mount-time checkpoint of the per-eraseblock summaries.
+ *
+ * For licensing information, see the file 'LICENCE' in this directory.
+ *
+ */
+
+#ifndef JFFS2_CHECKPOINT_H
+#define JFFS2_CHECKPOINT_H
+
+/* The first chunk of a checkpoint (the anchor) must live in one of the
+   first few eraseblocks, so that mount only has to look there for it. */
+#define JFFS2_CKPT_ANCHOR_BLOCKS 16
+
+/* Per-eraseblock states recorded in a checkpoint */
+#define JFFS2_CKPT_SCAN		0	/* scan the block as usual */
+#define JFFS2_CKPT_SUMMARY	1	/* replay the summary records */
+#define JFFS2_CKPT_SELF		2	/* holds a chunk of this checkpoint */
+
+/* The checkpoint data, split across the chunks, is laid out as:
+ *	jint32_t blocks[count];			eraseblocks holding the chunks
+ *	struct jffs2_ckpt_entry ent[nr_blocks];
+ *	summary records, each padded to 4 bytes, in eraseblock order
+ */
+struct jffs2_ckpt_entry
+{
+	jint32_t state;		/* JFFS2_CKPT_xxx */
+	jint32_t sumsize;	/* size of the summary node on flash */
+	jint32_t cln_mkr;	/* clean marker size from the summary */
+	jint32_t sum_num;	/* number of summary records */
+	jint32_t reclen;	/* length of the summary records */
+};
+
+/* Summary records of a full eraseblock, kept in core so that a checkpoint
+   can be written without reading the summary nodes back */
+struct jffs2_ckpt_sum
+{
+	uint32_t sumsize;
+	uint32_t cln_mkr;
+	uint32_t sum_num;
+	uint32_t reclen;
+	unsigned char rec[0];
+};
+
+#ifdef CONFIG_JFFS2_CHECKPOINT	/* CHECKPOINT SUPPORT ENABLED */
+
+#define jffs2_ckpt_live(c) ((c)->ckpt_anchor != NULL)
+int jffs2_ckpt_load(struct jffs2_sb_info *c);
+int jffs2_ckpt_scan_eraseblock(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
+			       uint32_t *pseudo_random);
+void jffs2_ckpt_scan_done(struct jffs2_sb_info *c);
+void jffs2_ckpt_keep_summary(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
+			     uint32_t sumsize, uint32_t cln_mkr, uint32_t sum_num,
+			     void *rec, uint32_t reclen);
+void jffs2_ckpt_forget(struct jffs2_eraseblock *jeb);
+void jffs2_ckpt_invalidate(struct jffs2_sb_info *c);
+int jffs2_ckpt_write(struct jffs2_sb_info *c);
+
+#else				/* CHECKPOINT DISABLED */
+
+#define jffs2_ckpt_live(c) (0)
+#define jffs2_ckpt_load(a) (0)
+#define jffs2_ckpt_scan_eraseblock(a,b,c) (0)
+#define jffs2_ckpt_scan_done(a)
+#define jffs2_ckpt_keep_summary(a,b,c,d,e,f,g)
+#define jffs2_ckpt_forget(a)
+#define jffs2_ckpt_invalidate(a)
+#define jffs2_ckpt_write(a) (0)
+
+#endif /* CONFIG_JFFS2_CHECKPOINT */
+
+#endif /* JFFS2_CHECKPOINT_H */
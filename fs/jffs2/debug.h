@@ -34,6 +34,7 @@
 #define JFFS2_DBG_NODEREF_MESSAGES
 #define JFFS2_DBG_INOCACHE_MESSAGES
 #define JFFS2_DBG_SUMMARY_MESSAGES
+#define JFFS2_DBG_CHECKPOINT_MESSAGES
 #define JFFS2_DBG_FSBUILD_MESSAGES
 #endif
 
@@ -163,6 +164,13 @@
 #define dbg_summary(fmt, ...)
 #endif
 
+/* Checkpoint debugging messages */
+#ifdef JFFS2_DBG_CHECKPOINT_MESSAGES
+#define dbg_ckpt(fmt, ...)	JFFS2_DEBUG(fmt, ##__VA_ARGS__)
+#else
+#define dbg_ckpt(fmt, ...)
+#endif
+
 /* File system build messages */
 #ifdef JFFS2_DBG_FSBUILD_MESSAGES
 #define dbg_fsbuild(fmt, ...)	JFFS2_DEBUG(fmt, ##__VA_ARGS__)
@@ -129,6 +129,13 @@ int jffs2_erase_pending_blocks(struct jffs2_sb_info *c, int count)
 				goto done;
 			}
 
+		} else if (jffs2_ckpt_live(c)) {
+			/* The checkpoint describes what is on the flash right
+			   now. Get rid of it before anything gets erased */
+			spin_unlock(&c->erase_completion_lock);
+			jffs2_ckpt_invalidate(c);
+			mutex_unlock(&c->erase_free_sem);
+
 		} else if (!list_empty(&c->erase_pending_list)) {
 			jeb = list_entry(c->erase_pending_list.next, struct jffs2_eraseblock, list);
 			D1(printk(KERN_DEBUG "Starting erase of pending block 0x%08x\n", jeb->offset));
@@ -328,6 +335,7 @@ void jffs2_free_jeb_node_refs(struct jffs2_sb_info *c, struct jffs2_eraseblock *
 		ref++;
 	}
 	jeb->first_node = jeb->last_node = NULL;
+	jffs2_ckpt_forget(jeb);
 }
 
 static int jffs2_block_check_erase(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb, uint32_t *bad_offset)
@@ -28,6 +28,7 @@
 #define JFFS2_SB_FLAG_BUILDING 4 /* File system building is in progress */
 
 struct jffs2_inodirty;
+struct jffs2_ckpt_entry;
 
 /* A struct for the overall file system control.  Pointers to
    jffs2_sb_info structs are named `c' in the source code.
@@ -67,7 +68,8 @@ struct jffs2_sb_info {
 	/* Number of free blocks there must be before we... */
 	uint8_t resv_blocks_write;	/* ... allow a normal filesystem write */
 	uint8_t resv_blocks_deletion;	/* ... allow a normal filesystem deletion */
-	uint8_t resv_blocks_gctrigger;	/* ... wake up the GC thread */
+	uint8_t resv_blocks_gctrigger;	/* ... throttle writers behind the GC thread */
+	uint8_t resv_blocks_gcahead;	/* ... wake up the GC thread to work ahead */
 	uint8_t resv_blocks_gcbad;	/* ... pick a block from the bad_list to GC */
 	uint8_t resv_blocks_gcmerge;	/* ... merge pages when garbage collecting */
 	/* Number of 'very dirty' blocks before we trigger immediate GC */
@@ -98,6 +100,7 @@ struct jffs2_sb_info {
 	spinlock_t erase_completion_lock;	/* Protect free_list and erasing_list
 						   against erase completion handler */
 	wait_queue_head_t erase_wait;		/* For waiting for erases to complete */
+	wait_queue_head_t gc_wait;		/* For writers throttled behind the GC thread */
 
 	wait_queue_head_t inocache_wq;
 	int inocache_hashsize;
@@ -127,6 +130,17 @@ struct jffs2_sb_info {
 
 	struct jffs2_summary *summary;		/* Summary information */
 
+#ifdef CONFIG_JFFS2_CHECKPOINT
+	struct jffs2_eraseblock *ckpt_anchor;	/* Anchor of the checkpoint on flash, if any */
+	uint32_t ckpt_seq;			/* Sequence number of the last checkpoint */
+	struct jffs2_eraseblock *ckpt_nextblock; /* Write position when it was taken */
+	uint32_t ckpt_next_free;
+	unsigned char *ckpt_data;		/* Checkpoint being replayed at mount */
+	struct jffs2_ckpt_entry *ckpt_ent;
+	uint32_t ckpt_pos;			/* Next summary records to replay */
+	uint32_t ckpt_replayed;			/* Blocks mounted without reading them */
+#endif
+
 #ifdef CONFIG_JFFS2_FS_XATTR
 #define XATTRINDEX_HASHSIZE	(57)
 	uint32_t highest_xid;
@@ -516,6 +516,7 @@ void jffs2_free_raw_node_refs(struct jffs2_sb_info *c)
 			this = next;
 		}
 		c->blocks[i].first_node = c->blocks[i].last_node = NULL;
+		jffs2_ckpt_forget(&c->blocks[i]);
 	}
 }
 
@@ -20,6 +20,7 @@
 #include "xattr.h"
 #include "acl.h"
 #include "summary.h"
+#include "checkpoint.h"
 
 #ifdef __ECOS
 #include "os-ecos.h"
@@ -287,6 +288,9 @@ struct jffs2_eraseblock
 	struct jffs2_raw_node_ref *last_node;
 
 	struct jffs2_raw_node_ref *gc_node;	/* Next node to be garbage collected */
+#ifdef CONFIG_JFFS2_CHECKPOINT
+	struct jffs2_ckpt_sum *ckpt_sum;	/* Summary records, for the next checkpoint */
+#endif
 };
 
 static inline int jffs2_blocks_use_vmalloc(struct jffs2_sb_info *c)
@@ -38,6 +38,41 @@
 static int jffs2_do_reserve_space(struct jffs2_sb_info *c,  uint32_t minsize,
 				  uint32_t *len, uint32_t sumsize);
 
+/* How long a writer waits for the GC thread before carrying on anyway */
+#define JFFS2_GC_THROTTLE_MS	20
+
+/* Once the free space drops below resv_blocks_gctrigger, make normal
+ * writers give the GC thread a chance to finish the eraseblock it is
+ * working on. Delaying each write a little is far better than letting
+ * them run into the write reservation, where every writer stalls while
+ * it garbage collects synchronously under alloc_sem. When there is not
+ * enough dirty space for GC to make progress (the same test as in
+ * jffs2_thread_should_wake()), waiting would only slow the writer down.
+ */
+static void jffs2_throttle_writer(struct jffs2_sb_info *c)
+{
+	uint32_t nr_avail;
+	int throttle;
+
+	spin_lock(&c->erase_completion_lock);
+	nr_avail = c->nr_free_blocks + c->nr_erasing_blocks;
+	throttle = c->gc_task && nr_avail < c->resv_blocks_gctrigger &&
+		nr_avail >= c->resv_blocks_write &&
+		c->dirty_size > c->nospc_dirty_size;
+	if (throttle)
+		jffs2_garbage_collect_trigger(c);
+	spin_unlock(&c->erase_completion_lock);
+
+	if (!throttle)
+		return;
+
+	D1(printk(KERN_DEBUG "jffs2_reserve_space(): nr_free_blocks %d, nr_erasing_blocks %d, waiting for GC\n",
+		  c->nr_free_blocks, c->nr_erasing_blocks));
+	wait_event_interruptible_timeout(c->gc_wait,
+		c->nr_free_blocks + c->nr_erasing_blocks >= c->resv_blocks_gctrigger || !c->gc_task,
+		msecs_to_jiffies(JFFS2_GC_THROTTLE_MS));
+}
+
 int jffs2_reserve_space(struct jffs2_sb_info *c, uint32_t minsize,
 			uint32_t *len, int prio, uint32_t sumsize)
 {
@@ -47,6 +82,8 @@ int jffs2_reserve_space(struct jffs2_sb_info *c, uint32_t minsize,
 	minsize = PAD(minsize);
 
 	D1(printk(KERN_DEBUG "jffs2_reserve_space(): Requested 0x%x bytes\n", minsize));
+	if (prio == ALLOC_NORMAL)
+		jffs2_throttle_writer(c);
 	mutex_lock(&c->alloc_sem);
 
 	D1(printk(KERN_DEBUG "jffs2_reserve_space(): alloc sem got\n"));
@@ -766,7 +803,7 @@ int jffs2_thread_should_wake(struct jffs2_sb_info *c)
 	 */
 	dirty = c->dirty_size + c->erasing_size - c->nr_erasing_blocks * c->sector_size;
 
-	if (c->nr_free_blocks + c->nr_erasing_blocks < c->resv_blocks_gctrigger &&
+	if (c->nr_free_blocks + c->nr_erasing_blocks < c->resv_blocks_gcahead &&
 			(dirty > c->nospc_dirty_size))
 		ret = 1;
 
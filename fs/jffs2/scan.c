@@ -136,6 +136,10 @@ int jffs2_scan_medium(struct jffs2_sb_info *c)
 		}
 	}
 
+	ret = jffs2_ckpt_load(c);
+	if (ret)
+		goto out;
+
 	for (i=0; i<c->nr_blocks; i++) {
 		struct jffs2_eraseblock *jeb = &c->blocks[i];
 
@@ -144,8 +148,12 @@ int jffs2_scan_medium(struct jffs2_sb_info *c)
 		/* reset summary info for next eraseblock scan */
 		jffs2_sum_reset_collected(s);
 
-		ret = jffs2_scan_eraseblock(c, jeb, buf_size?flashbuf:(flashbuf+jeb->offset),
-						buf_size, s);
+		/* Blocks which haven't changed since the checkpoint
+		   don't have to be read at all */
+		ret = jffs2_ckpt_scan_eraseblock(c, jeb, &pseudo_random);
+		if (!ret)
+			ret = jffs2_scan_eraseblock(c, jeb, buf_size?flashbuf:(flashbuf+jeb->offset),
+						    buf_size, s);
 
 		if (ret < 0)
 			goto out;
@@ -266,6 +274,7 @@ int jffs2_scan_medium(struct jffs2_sb_info *c)
 	}
 	ret = 0;
  out:
+	jffs2_ckpt_scan_done(c);
 	if (buf_size)
 		kfree(flashbuf);
 #ifndef __ECOS
@@ -854,6 +863,15 @@ scan_more:
 			}
 			break;
 
+#ifdef CONFIG_JFFS2_CHECKPOINT
+		case JFFS2_NODETYPE_CHECKPOINT:
+			/* An old or unusable checkpoint. Just dirty space */
+			if ((err = jffs2_scan_dirty_space(c, jeb, PAD(je32_to_cpu(node->totlen)))))
+				return err;
+			ofs += PAD(je32_to_cpu(node->totlen));
+			break;
+#endif
+
 		case JFFS2_NODETYPE_PADDING:
 			if (jffs2_sum_active())
 				jffs2_sum_add_padding_mem(s, je32_to_cpu(node->totlen));
@@ -382,7 +382,8 @@ static struct jffs2_raw_node_ref *sum_link_node_ref(struct jffs2_sb_info *c,
 /* Process the stored summary information - helper function for jffs2_sum_scan_sumnode() */
 
 static int jffs2_sum_process_sum_data(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
-				struct jffs2_raw_summary *summary, uint32_t *pseudo_random)
+				void *records, uint32_t sum_num, uint32_t *reclen,
+				uint32_t *pseudo_random)
 {
 	struct jffs2_inode_cache *ic;
 	struct jffs2_full_dirent *fd;
@@ -390,9 +391,9 @@ static int jffs2_sum_process_sum_data(struct jffs2_sb_info *c, struct jffs2_eras
 	int i, ino;
 	int err;
 
-	sp = summary->sum;
+	sp = records;
 
-	for (i=0; i<je32_to_cpu(summary->sum_num); i++) {
+	for (i=0; i<sum_num; i++) {
 		dbg_summary("processing summary index %d\n", i);
 
 		cond_resched();
@@ -560,6 +561,7 @@ static int jffs2_sum_process_sum_data(struct jffs2_sb_info *c, struct jffs2_eras
 			}
 		}
 	}
+	*reclen = sp - records;
 	return 0;
 }
 
@@ -569,13 +571,10 @@ int jffs2_sum_scan_sumnode(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb
 			   uint32_t *pseudo_random)
 {
 	struct jffs2_unknown_node crcnode;
-	int ret, ofs;
 	uint32_t crc;
 
-	ofs = c->sector_size - sumsize;
-
 	dbg_summary("summary found for 0x%08x at 0x%08x (0x%x bytes)\n",
-		    jeb->offset, jeb->offset + ofs, sumsize);
+		    jeb->offset, jeb->offset + c->sector_size - sumsize, sumsize);
 
 	/* OK, now check for node validity and CRC */
 	crcnode.magic = cpu_to_je16(JFFS2_MAGIC_BITMASK);
@@ -608,7 +607,28 @@ int jffs2_sum_scan_sumnode(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb
 		goto crc_err;
 	}
 
-	if ( je32_to_cpu(summary->cln_mkr) ) {
+	return jffs2_sum_scan_records(c, jeb, sumsize, je32_to_cpu(summary->cln_mkr),
+				      je32_to_cpu(summary->sum_num), summary->sum,
+				      pseudo_random);
+
+crc_err:
+	JFFS2_WARNING("Summary node crc error, skipping summary information.\n");
+
+	return 0;
+}
+
+/* Process already validated summary records - called from jffs2_sum_scan_sumnode()
+   and, for a mount from a checkpoint, from jffs2_ckpt_scan_eraseblock() */
+int jffs2_sum_scan_records(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
+			   uint32_t sumsize, uint32_t cln_mkr, uint32_t sum_num,
+			   void *records, uint32_t *pseudo_random)
+{
+	uint32_t ofs, reclen;
+	int ret;
+
+	ofs = c->sector_size - sumsize;
+
+	if ( cln_mkr ) {
 
 		dbg_summary("Summary : CLEANMARKER node \n");
 
@@ -616,23 +636,23 @@ int jffs2_sum_scan_sumnode(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb
 		if (ret)
 			return ret;
 
-		if (je32_to_cpu(summary->cln_mkr) != c->cleanmarker_size) {
+		if (cln_mkr != c->cleanmarker_size) {
 			dbg_summary("CLEANMARKER node has totlen 0x%x != normal 0x%x\n",
-				je32_to_cpu(summary->cln_mkr), c->cleanmarker_size);
-			if ((ret = jffs2_scan_dirty_space(c, jeb, PAD(je32_to_cpu(summary->cln_mkr)))))
+				cln_mkr, c->cleanmarker_size);
+			if ((ret = jffs2_scan_dirty_space(c, jeb, PAD(cln_mkr))))
 				return ret;
 		} else if (jeb->first_node) {
 			dbg_summary("CLEANMARKER node not first node in block "
 					"(0x%08x)\n", jeb->offset);
-			if ((ret = jffs2_scan_dirty_space(c, jeb, PAD(je32_to_cpu(summary->cln_mkr)))))
+			if ((ret = jffs2_scan_dirty_space(c, jeb, PAD(cln_mkr))))
 				return ret;
 		} else {
 			jffs2_link_node_ref(c, jeb, jeb->offset | REF_NORMAL,
-					    je32_to_cpu(summary->cln_mkr), NULL);
+					    cln_mkr, NULL);
 		}
 	}
 
-	ret = jffs2_sum_process_sum_data(c, jeb, summary, pseudo_random);
+	ret = jffs2_sum_process_sum_data(c, jeb, records, sum_num, &reclen, pseudo_random);
 	/* -ENOTRECOVERABLE isn't a fatal error -- it means we should do a full
 	   scan of this eraseblock. So return zero */
 	if (ret == -ENOTRECOVERABLE)
@@ -640,6 +660,8 @@ int jffs2_sum_scan_sumnode(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb
 	if (ret)
 		return ret;		/* real error */
 
+	jffs2_ckpt_keep_summary(c, jeb, sumsize, cln_mkr, sum_num, records, reclen);
+
 	/* for PARANOIA_CHECK */
 	ret = jffs2_prealloc_raw_node_refs(c, jeb, 2);
 	if (ret)
@@ -657,11 +679,6 @@ int jffs2_sum_scan_sumnode(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb
 	}
 
 	return jffs2_scan_classify_jeb(c, jeb);
-
-crc_err:
-	JFFS2_WARNING("Summary node crc error, skipping summary information.\n");
-
-	return 0;
 }
 
 /* Write summary data to flash - helper function for jffs2_sum_write_sumnode() */
@@ -673,7 +690,7 @@ static int jffs2_sum_write_data(struct jffs2_sb_info *c, struct jffs2_eraseblock
 	union jffs2_sum_mem *temp;
 	struct jffs2_sum_marker *sm;
 	struct kvec vecs[2];
-	uint32_t sum_ofs;
+	uint32_t sum_ofs, sum_num, reclen;
 	void *wpage;
 	int ret;
 	size_t retlen;
@@ -708,6 +725,7 @@ static int jffs2_sum_write_data(struct jffs2_sb_info *c, struct jffs2_eraseblock
 	isum.padded = cpu_to_je32(c->summary->sum_padded);
 	isum.cln_mkr = cpu_to_je32(c->cleanmarker_size);
 	isum.sum_num = cpu_to_je32(c->summary->sum_num);
+	sum_num = c->summary->sum_num;
 	wpage = c->summary->sum_buf;
 
 	while (c->summary->sum_num) {
@@ -790,8 +808,11 @@ static int jffs2_sum_write_data(struct jffs2_sb_info *c, struct jffs2_eraseblock
 		c->summary->sum_num--;
 	}
 
+	if (jffs2_sum_is_disabled(c->summary))
+		sum_num = 0;	/* don't checkpoint it */
 	jffs2_sum_reset_collected(c->summary);
 
+	reclen = wpage - (void *)c->summary->sum_buf;
 	wpage += padsize;
 
 	sm = wpage;
@@ -834,6 +855,10 @@ static int jffs2_sum_write_data(struct jffs2_sb_info *c, struct jffs2_eraseblock
 	jffs2_link_node_ref(c, jeb, sum_ofs | REF_NORMAL, infosize, NULL);
 	spin_unlock(&c->erase_completion_lock);
 
+	if (sum_num)
+		jffs2_ckpt_keep_summary(c, jeb, infosize, c->cleanmarker_size,
+					sum_num, c->summary->sum_buf, reclen);
+
 	return 0;
 }
 
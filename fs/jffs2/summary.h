@@ -189,6 +189,9 @@ int jffs2_sum_add_xref_mem(struct jffs2_summary *s, struct jffs2_raw_xref *rr, u
 int jffs2_sum_scan_sumnode(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
 			   struct jffs2_raw_summary *summary, uint32_t sumlen,
 			   uint32_t *pseudo_random);
+int jffs2_sum_scan_records(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb,
+			   uint32_t sumsize, uint32_t cln_mkr, uint32_t sum_num,
+			   void *records, uint32_t *pseudo_random);
 
 #else				/* SUMMARY DISABLED */
 
@@ -207,6 +210,7 @@ int jffs2_sum_scan_sumnode(struct jffs2_sb_info *c, struct jffs2_eraseblock *jeb
 #define jffs2_sum_add_xattr_mem(a,b,c)
 #define jffs2_sum_add_xref_mem(a,b,c)
 #define jffs2_sum_scan_sumnode(a,b,c,d,e) (0)
+#define jffs2_sum_scan_records(a,b,c,d,e,f,g) (0)
 
 #endif /* CONFIG_JFFS2_SUMMARY */
 
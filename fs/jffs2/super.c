@@ -84,6 +84,10 @@ static int jffs2_sync_fs(struct super_block *sb, int wait)
 	mutex_lock(&c->alloc_sem);
 	jffs2_flush_wbuf_pad(c);
 	mutex_unlock(&c->alloc_sem);
+
+	/* This is also the last thing to happen before a clean unmount */
+	if (wait && !jffs2_is_readonly(c))
+		jffs2_ckpt_write(c);
 	return 0;
 }
 
@@ -171,6 +175,7 @@ static int jffs2_fill_super(struct super_block *sb, void *data, int silent)
 	mutex_init(&c->alloc_sem);
 	mutex_init(&c->erase_free_sem);
 	init_waitqueue_head(&c->erase_wait);
+	init_waitqueue_head(&c->gc_wait);
 	init_waitqueue_head(&c->inocache_wq);
 	spin_lock_init(&c->erase_completion_lock);
 	spin_lock_init(&c->inocache_lock);
@@ -254,6 +259,7 @@ static int __init init_jffs2_fs(void)
 	BUILD_BUG_ON(sizeof(struct jffs2_raw_dirent) != 40);
 	BUILD_BUG_ON(sizeof(struct jffs2_raw_inode) != 68);
 	BUILD_BUG_ON(sizeof(struct jffs2_raw_summary) != 32);
+	BUILD_BUG_ON(sizeof(struct jffs2_raw_checkpoint) != 44);
 
 	printk(KERN_INFO "JFFS2 version 2.2."
 #ifdef CONFIG_JFFS2_FS_WRITEBUFFER
@@ -261,6 +267,9 @@ static int __init init_jffs2_fs(void)
 #endif
 #ifdef CONFIG_JFFS2_SUMMARY
 	       " (SUMMARY) "
+#endif
+#ifdef CONFIG_JFFS2_CHECKPOINT
+	       " (CHECKPOINT) "
 #endif
 	       " © 2001-2006 Red Hat, Inc.\n");
 
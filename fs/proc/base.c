@@ -412,6 +412,64 @@ static int proc_pid_schedstat(struct task_struct *task, char *buffer)
 			(unsigned long long)task->sched_info.run_delay,
 			task->sched_info.pcount);
 }
+
+/*
+ * Provides /proc/PID/schedstat_hist: the histogram of the latencies
+ * between the wakeups of a fair class task and it running
+ */
+static int proc_pid_schedstat_hist(struct task_struct *task, char *buffer)
+{
+	int i, len = 0;
+
+	for (i = 0; i < SCHED_LAT_BUCKETS; i++)
+		len += sprintf(buffer + len, i ? " %u" : "%u",
+			       task->se.statistics.wakeup_lat_hist[i]);
+	buffer[len++] = '\n';
+
+	return len;
+}
+#endif
+
+#ifdef CONFIG_TASK_DELAY_ACCT
+/*
+ * Provides /proc/PID/reclaim: the number of times the task stalled in
+ * direct memory reclaim, and the total and longest stall, in ns.
+ */
+static int proc_pid_reclaim(struct task_struct *task, char *buffer)
+{
+	unsigned long flags;
+	unsigned long long delay = 0, delay_max = 0;
+	unsigned int count = 0;
+
+	if (task->delays) {
+		spin_lock_irqsave(&task->delays->lock, flags);
+		count = task->delays->freepages_count;
+		delay = task->delays->freepages_delay;
+		delay_max = task->delays->freepages_delay_max;
+		spin_unlock_irqrestore(&task->delays->lock, flags);
+	}
+
+	return sprintf(buffer, "%u %llu %llu\n", count, delay, delay_max);
+}
+#endif
+
+#ifdef CONFIG_KSM
+/*
+ * Provides /proc/PID/ksm_merging_pages: the number of pages of the task
+ * currently mapping a page shared by KSM.
+ */
+static int proc_pid_ksm_merging_pages(struct task_struct *task, char *buffer)
+{
+	struct mm_struct *mm = get_task_mm(task);
+	unsigned long pages = 0;
+
+	if (mm) {
+		pages = mm->ksm_merging_pages;
+		mmput(mm);
+	}
+
+	return sprintf(buffer, "%lu\n", pages);
+}
 #endif
 
 #ifdef CONFIG_LATENCYTOP
@@ -2858,6 +2916,7 @@ static const struct pid_entry tgid_base_stuff[] = {
 #ifdef CONFIG_PROC_PAGE_MONITOR
 	REG("clear_refs", S_IWUSR, proc_clear_refs_operations),
 	REG("smaps",      S_IRUGO, proc_smaps_operations),
+	ONE("pss",        S_IRUGO, proc_pid_pss),
 	REG("pagemap",    S_IRUGO, proc_pagemap_operations),
 #endif
 #ifdef CONFIG_SECURITY
@@ -2871,6 +2930,13 @@ static const struct pid_entry tgid_base_stuff[] = {
 #endif
 #ifdef CONFIG_SCHEDSTATS
 	INF("schedstat",  S_IRUGO, proc_pid_schedstat),
+	INF("schedstat_hist", S_IRUGO, proc_pid_schedstat_hist),
+#endif
+#ifdef CONFIG_TASK_DELAY_ACCT
+	INF("reclaim",    S_IRUGO, proc_pid_reclaim),
+#endif
+#ifdef CONFIG_KSM
+	INF("ksm_merging_pages", S_IRUGO, proc_pid_ksm_merging_pages),
 #endif
 #ifdef CONFIG_LATENCYTOP
 	REG("latency",  S_IRUGO, proc_lstats_operations),
@@ -3199,6 +3265,7 @@ static const struct pid_entry tid_base_stuff[] = {
 #ifdef CONFIG_PROC_PAGE_MONITOR
 	REG("clear_refs", S_IWUSR, proc_clear_refs_operations),
 	REG("smaps",     S_IRUGO, proc_smaps_operations),
+	ONE("pss",       S_IRUGO, proc_pid_pss),
 	REG("pagemap",    S_IRUGO, proc_pagemap_operations),
 #endif
 #ifdef CONFIG_SECURITY
@@ -3212,6 +3279,13 @@ static const struct pid_entry tid_base_stuff[] = {
 #endif
 #ifdef CONFIG_SCHEDSTATS
 	INF("schedstat", S_IRUGO, proc_pid_schedstat),
+	INF("schedstat_hist", S_IRUGO, proc_pid_schedstat_hist),
+#endif
+#ifdef CONFIG_TASK_DELAY_ACCT
+	INF("reclaim",   S_IRUGO, proc_pid_reclaim),
+#endif
+#ifdef CONFIG_KSM
+	INF("ksm_merging_pages", S_IRUGO, proc_pid_ksm_merging_pages),
 #endif
 #ifdef CONFIG_LATENCYTOP
 	REG("latency",  S_IRUGO, proc_lstats_operations),
@@ -496,6 +496,56 @@ const struct file_operations proc_smaps_operations = {
 	.release	= seq_release_private,
 };
 
+/*
+ * Rss, Pss and Uss (the pages mapped by this mm only) of a whole mm, in
+ * kB. This is the page table walk smaps does, in a single pass under
+ * mmap_sem and without formatting a record for every mapping, for
+ * monitors which only want the totals of every process.
+ */
+void task_pss(struct mm_struct *mm, unsigned long *rss,
+	      unsigned long *pss, unsigned long *uss)
+{
+	struct vm_area_struct *vma;
+	struct mem_size_stats mss;
+	struct mm_walk pss_walk = {
+		.pmd_entry = smaps_pte_range,
+		.mm = mm,
+		.private = &mss,
+	};
+
+	memset(&mss, 0, sizeof mss);
+	down_read(&mm->mmap_sem);
+	for (vma = mm->mmap; vma; vma = vma->vm_next) {
+		if (is_vm_hugetlb_page(vma))
+			continue;
+		mss.vma = vma;
+		walk_page_range(vma->vm_start, vma->vm_end, &pss_walk);
+		cond_resched();
+	}
+	up_read(&mm->mmap_sem);
+
+	*rss = mss.resident >> 10;
+	*pss = (unsigned long)(mss.pss >> (10 + PSS_SHIFT));
+	*uss = (mss.private_clean + mss.private_dirty) >> 10;
+}
+
+int proc_pid_pss(struct seq_file *m, struct pid_namespace *ns,
+			struct pid *pid, struct task_struct *task)
+{
+	unsigned long rss = 0, pss = 0, uss = 0;
+	struct mm_struct *mm = mm_for_maps(task);
+
+	if (IS_ERR(mm))
+		return PTR_ERR(mm);
+	if (mm) {
+		task_pss(mm, &rss, &pss, &uss);
+		mmput(mm);
+	}
+	seq_printf(m, "%lu %lu %lu\n", rss, pss, uss);
+
+	return 0;
+}
+
 static int clear_refs_pte_range(pmd_t *pmd, unsigned long addr,
 				unsigned long end, struct mm_walk *walk)
 {
@@ -0,0 +1,38 @@
+#ifndef _LINUX_BOOT_PREFETCH_H
+#define _LINUX_BOOT_PREFETCH_H
+
+#include <linux/compiler.h>
+#include <linux/types.h>
+
+struct file;
+
+#ifdef CONFIG_BOOT_PREFETCH
+
+extern int boot_prefetch_recording;
+
+extern void __boot_prefetch_record(struct file *file, pgoff_t start,
+				   unsigned long nr_pages);
+extern void boot_prefetch_start(void);
+
+/* Called for the pages page cache readahead reads from disk */
+static inline void boot_prefetch_record(struct file *file, pgoff_t start,
+					unsigned long nr_pages)
+{
+	if (unlikely(boot_prefetch_recording))
+		__boot_prefetch_record(file, start, nr_pages);
+}
+
+#else
+
+static inline void boot_prefetch_record(struct file *file, pgoff_t start,
+					unsigned long nr_pages)
+{
+}
+
+static inline void boot_prefetch_start(void)
+{
+}
+
+#endif /* CONFIG_BOOT_PREFETCH */
+
+#endif /* _LINUX_BOOT_PREFETCH_H */
@@ -0,0 +1,67 @@
+#ifndef _LINUX_BOOT_PROFILE_H
+#define _LINUX_BOOT_PROFILE_H
+
+#include <linux/compiler.h>
+#include <linux/types.h>
+
+/* What a boot profile record measures */
+enum boot_profile_event {
+	BOOT_PROFILE_INITCALL,		/* built-in or module initcall */
+	BOOT_PROFILE_PROBE,		/* driver probe of a device */
+	BOOT_PROFILE_ASYNC,		/* async_schedule() function */
+	BOOT_PROFILE_INITRAMFS,		/* initramfs/initrd unpacking */
+	BOOT_PROFILE_MOUNT_ROOT,	/* mount of the root filesystem */
+	BOOT_PROFILE_INIT_EXEC,		/* exec of init: end of the boot */
+	BOOT_PROFILE_NR_EVENTS
+};
+
+#ifdef CONFIG_BOOT_PROFILE
+
+extern int boot_profile_recording;
+
+extern void __boot_profile_record(enum boot_profile_event event,
+				  const void *fn, const char *name,
+				  u64 start, int ret);
+extern u64 __boot_profile_clock(void);
+
+/* Returns the start time to pass to boot_profile_record() */
+static inline u64 boot_profile_start(void)
+{
+	return unlikely(boot_profile_recording) ? __boot_profile_clock() : 0;
+}
+
+/*
+ * Record an event which started at @start and ends now. It is named
+ * after the function @fn if there is one, after @name otherwise.
+ */
+static inline void boot_profile_record(enum boot_profile_event event,
+				       const void *fn, const char *name,
+				       u64 start, int ret)
+{
+	if (unlikely(boot_profile_recording))
+		__boot_profile_record(event, fn, name, start, ret);
+}
+
+/* Record an attempt to exec init, which stops the recording */
+extern void boot_profile_init_exec(const char *name, u64 start);
+
+#else
+
+static inline u64 boot_profile_start(void)
+{
+	return 0;
+}
+
+static inline void boot_profile_record(enum boot_profile_event event,
+				       const void *fn, const char *name,
+				       u64 start, int ret)
+{
+}
+
+static inline void boot_profile_init_exec(const char *name, u64 start)
+{
+}
+
+#endif /* CONFIG_BOOT_PROFILE */
+
+#endif /* _LINUX_BOOT_PROFILE_H */
@@ -916,6 +916,11 @@ struct file_ra_state {
 	unsigned int ra_pages;		/* Maximum readahead window */
 	unsigned int mmap_miss;		/* Cache miss stat for mmap accesses */
 	loff_t prev_pos;		/* Cache last read() position */
+#ifdef CONFIG_READAHEAD_FEEDBACK
+	unsigned int ra_issued;		/* Pages read ahead, */
+	unsigned int ra_hits;		/* how many of them were accessed, */
+	unsigned int ra_shift;		/* and ra_pages scaled down by them */
+#endif
 };
 
 /*
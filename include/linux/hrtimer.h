@@ -173,6 +173,8 @@ enum  hrtimer_base_type {
  * @nr_retries:		Total number of hrtimer interrupt retries
  * @nr_hangs:		Total number of hrtimer interrupt hangs
  * @max_hang_time:	Maximum time spent in hrtimer_interrupt
+ * @nr_coalesced:	Timers hrtimer_interrupt() ran before their hard
+ *			expiry time, by the event of another timer
  */
 struct hrtimer_cpu_base {
 	raw_spinlock_t			lock;
@@ -186,8 +188,33 @@ struct hrtimer_cpu_base {
 	unsigned long			nr_hangs;
 	ktime_t				max_hang_time;
 #endif
+	unsigned long			nr_coalesced;
 };
 
+/**
+ * struct hrtimer_class - coalescing window of a kind of timers
+ * @name:	name, to tune the window in debugfs "hrtimer_classes"
+ * @slack_ns:	how late the timers of the class may expire
+ * @list:	in the list of classes
+ *
+ * Timers started with hrtimer_start_class() may expire up to @slack_ns
+ * late, so that they can be run by the event of another timer instead
+ * of waking the CPU up themselves. Latency sensitive timers should not
+ * use a class.
+ */
+struct hrtimer_class {
+	const char			*name;
+	unsigned long			slack_ns;
+	struct list_head		list;
+};
+
+#define DEFINE_HRTIMER_CLASS(_name, _slack_ns)				\
+	struct hrtimer_class _name = {					\
+		.name		= #_name,				\
+		.slack_ns	= _slack_ns,				\
+		.list		= LIST_HEAD_INIT(_name.list),		\
+	}
+
 static inline void hrtimer_set_expires(struct hrtimer *timer, ktime_t time)
 {
 	timer->node.expires = time;
@@ -358,6 +385,17 @@ __hrtimer_start_range_ns(struct hrtimer *timer, ktime_t tim,
 extern int hrtimer_cancel(struct hrtimer *timer);
 extern int hrtimer_try_to_cancel(struct hrtimer *timer);
 
+extern void hrtimer_class_register(struct hrtimer_class *class);
+extern void hrtimer_class_unregister(struct hrtimer_class *class);
+
+static inline int hrtimer_start_class(struct hrtimer *timer, ktime_t tim,
+				      const struct hrtimer_class *class,
+				      const enum hrtimer_mode mode)
+{
+	return hrtimer_start_range_ns(timer, tim,
+				      ACCESS_ONCE(class->slack_ns), mode);
+}
+
 static inline int hrtimer_start_expires(struct hrtimer *timer,
 						enum hrtimer_mode mode)
 {
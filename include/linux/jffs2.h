@@ -68,6 +68,10 @@
 #define JFFS2_NODETYPE_XATTR (JFFS2_FEATURE_INCOMPAT | JFFS2_NODE_ACCURATE | 8)
 #define JFFS2_NODETYPE_XREF (JFFS2_FEATURE_INCOMPAT | JFFS2_NODE_ACCURATE | 9)
 
+/* Kernels which can't validate a checkpoint must not erase anything while
+   one is on the medium, so make them mount read-only */
+#define JFFS2_NODETYPE_CHECKPOINT (JFFS2_FEATURE_ROCOMPAT | JFFS2_NODE_ACCURATE | 10)
+
 /* XATTR Related */
 #define JFFS2_XPREFIX_USER		1	/* for "user." */
 #define JFFS2_XPREFIX_SECURITY		2	/* for "security." */
@@ -78,7 +82,6 @@
 #define JFFS2_ACL_VERSION		0x0001
 
 // Maybe later...
-//#define JFFS2_NODETYPE_CHECKPOINT (JFFS2_FEATURE_RWCOMPAT_DELETE | JFFS2_NODE_ACCURATE | 3)
 //#define JFFS2_NODETYPE_OPTIONS (JFFS2_FEATURE_RWCOMPAT_COPY | JFFS2_NODE_ACCURATE | 4)
 
 
@@ -204,6 +207,24 @@ struct jffs2_raw_summary
 	jint32_t sum[0]; 	/* inode summary info */
 };
 
+struct jffs2_raw_checkpoint
+{
+	jint16_t magic;
+	jint16_t nodetype;	/* = JFFS2_NODETYPE_CHECKPOINT */
+	jint32_t totlen;	/* covers the rest of the eraseblock */
+	jint32_t hdr_crc;
+	jint32_t seq;		/* checkpoint sequence number */
+	jint16_t index;		/* position of this chunk in the checkpoint */
+	jint16_t count;		/* number of eraseblocks holding the checkpoint */
+	jint32_t sector_size;	/* geometry the checkpoint was taken with */
+	jint32_t nr_blocks;
+	jint32_t cln_mkr;	/* clean marker size, 0 = OOB clean marker */
+	jint32_t len;		/* length of the data in this chunk */
+	jint32_t data_crc;
+	jint32_t node_crc;
+	__u8 data[0];
+};
+
 union jffs2_node_union
 {
 	struct jffs2_raw_inode i;
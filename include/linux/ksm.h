@@ -24,6 +24,17 @@ int ksm_madvise(struct vm_area_struct *vma, unsigned long start,
 		unsigned long end, int advice, unsigned long *vm_flags);
 int __ksm_enter(struct mm_struct *mm);
 void __ksm_exit(struct mm_struct *mm);
+int ksm_merge_any(struct mm_struct *mm);
+unsigned long __ksm_mmap_flags(struct mm_struct *mm, unsigned long vm_flags);
+
+/* New anonymous areas are mergeable if the whole process is */
+static inline unsigned long ksm_mmap_flags(struct mm_struct *mm,
+					   unsigned long vm_flags)
+{
+	if (test_bit(MMF_VM_MERGE_ANY, &mm->flags))
+		return __ksm_mmap_flags(mm, vm_flags);
+	return vm_flags;
+}
 
 static inline int ksm_fork(struct mm_struct *mm, struct mm_struct *oldmm)
 {
@@ -101,6 +112,17 @@ static inline void ksm_exit(struct mm_struct *mm)
 {
 }
 
+static inline int ksm_merge_any(struct mm_struct *mm)
+{
+	return 0;
+}
+
+static inline unsigned long ksm_mmap_flags(struct mm_struct *mm,
+					   unsigned long vm_flags)
+{
+	return vm_flags;
+}
+
 static inline int PageKsm(struct page *page)
 {
 	return 0;
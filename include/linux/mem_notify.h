@@ -0,0 +1,31 @@
+#ifndef _LINUX_MEM_NOTIFY_H
+#define _LINUX_MEM_NOTIFY_H
+
+#include <linux/types.h>
+
+/* Reclaim pressure levels reported by /dev/mem_notify */
+enum mem_notify_level {
+	MEM_NOTIFY_LOW,
+	MEM_NOTIFY_MEDIUM,
+	MEM_NOTIFY_CRITICAL,
+	NR_MEM_NOTIFY_LEVELS
+};
+
+#ifdef CONFIG_MEM_NOTIFY
+
+extern int sysctl_mem_notify_medium;
+extern int sysctl_mem_notify_critical;
+
+extern void mem_notify_vmscan(gfp_t gfp_mask, unsigned long scanned,
+			      unsigned long reclaimed);
+
+#else
+
+static inline void mem_notify_vmscan(gfp_t gfp_mask, unsigned long scanned,
+				     unsigned long reclaimed)
+{
+}
+
+#endif /* CONFIG_MEM_NOTIFY */
+
+#endif /* _LINUX_MEM_NOTIFY_H */
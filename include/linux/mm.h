@@ -30,6 +30,7 @@ extern unsigned long num_physpages;
 extern unsigned long totalram_pages;
 extern void * high_memory;
 extern int page_cluster;
+extern int swap_locality;
 
 #ifdef CONFIG_SYSCTL
 extern int sysctl_legacy_va_layout;
@@ -1162,6 +1163,13 @@ static inline void sync_mm_rss(struct task_struct *task, struct mm_struct *mm)
 }
 #endif
 
+/*
+ * Number of buckets in the histograms of direct reclaim stall times:
+ * the first one is for stalls shorter than 16us, and each next one
+ * for stalls twice as long, the last one counting all longer stalls.
+ */
+#define RECLAIM_HIST_BUCKETS 16
+
 /*
  * A callback you can register to apply pressure to ageable caches.
  *
@@ -1184,6 +1192,7 @@ struct shrinker {
 	/* These are for internal use */
 	struct list_head list;
 	long nr;	/* objs pending delete */
+	atomic_long_t stall_hist[RECLAIM_HIST_BUCKETS];	/* direct reclaim */
 };
 #define DEFAULT_SEEKS 2 /* A good number if you don't know better. */
 extern void register_shrinker(struct shrinker *);
@@ -1517,6 +1526,34 @@ unsigned long ra_submit(struct file_ra_state *ra,
 			struct address_space *mapping,
 			struct file *filp);
 
+#ifdef CONFIG_READAHEAD_FEEDBACK
+void __readahead_hit(struct file_ra_state *ra, struct page *page);
+
+/* Account a page cache access, through @ra, to readahead which got it */
+static inline void readahead_hit(struct file_ra_state *ra, struct page *page)
+{
+	if (PageRaUnused(page))
+		__readahead_hit(ra, page);
+}
+
+/* Account a page leaving the page cache without having been accessed */
+static inline void readahead_evict(struct page *page)
+{
+	if (PageRaUnused(page)) {
+		ClearPageRaUnused(page);
+		count_vm_event(READAHEAD_WASTE);
+	}
+}
+#else
+static inline void readahead_hit(struct file_ra_state *ra, struct page *page)
+{
+}
+
+static inline void readahead_evict(struct page *page)
+{
+}
+#endif
+
 /* Do stack extension */
 extern int expand_stack(struct vm_area_struct *vma, unsigned long address);
 #if VM_GROWSUP
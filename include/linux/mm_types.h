@@ -317,6 +317,9 @@ struct mm_struct {
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
 	pgtable_t pmd_huge_pte; /* protected by page_table_lock */
 #endif
+#ifdef CONFIG_KSM
+	unsigned long ksm_merging_pages; /* pages mapping a KSM page */
+#endif
 };
 
 /* Future-safe accessor for struct mm_struct's cpu_vm_mask. */
@@ -106,6 +106,9 @@ enum pageflags {
 #endif
 #ifdef CONFIG_TRANSPARENT_HUGEPAGE
 	PG_compound_lock,
+#endif
+#ifdef CONFIG_READAHEAD_FEEDBACK
+	PG_ra_unused,		/* Read ahead, not accessed yet */
 #endif
 	__NR_PAGEFLAGS,
 
@@ -185,6 +188,9 @@ static inline void SetPage##uname(struct page *page) {  }
 #define CLEARPAGEFLAG_NOOP(uname)					\
 static inline void ClearPage##uname(struct page *page) {  }
 
+#define __SETPAGEFLAG_NOOP(uname)					\
+static inline void __SetPage##uname(struct page *page) {  }
+
 #define __CLEARPAGEFLAG_NOOP(uname)					\
 static inline void __ClearPage##uname(struct page *page) {  }
 
@@ -269,6 +275,14 @@ PAGEFLAG(Uncached, uncached)
 PAGEFLAG_FALSE(Uncached)
 #endif
 
+#ifdef CONFIG_READAHEAD_FEEDBACK
+PAGEFLAG(RaUnused, ra_unused) __SETPAGEFLAG(RaUnused, ra_unused)
+	TESTCLEARFLAG(RaUnused, ra_unused)
+#else
+PAGEFLAG_FALSE(RaUnused) SETPAGEFLAG_NOOP(RaUnused)
+	__SETPAGEFLAG_NOOP(RaUnused) TESTCLEARFLAG_FALSE(RaUnused)
+#endif
+
 #ifdef CONFIG_MEMORY_FAILURE
 PAGEFLAG(HWPoison, hwpoison)
 TESTSCFLAG(HWPoison, hwpoison)
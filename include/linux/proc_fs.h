@@ -252,6 +252,17 @@ kclist_add(struct kcore_list *new, void *addr, size_t size, int type)
 extern void kclist_add(struct kcore_list *, void *, size_t, int type);
 #endif
 
+#ifdef CONFIG_PROC_PAGE_MONITOR
+extern void task_pss(struct mm_struct *mm, unsigned long *rss,
+		     unsigned long *pss, unsigned long *uss);
+#else
+static inline void task_pss(struct mm_struct *mm, unsigned long *rss,
+			    unsigned long *pss, unsigned long *uss)
+{
+	*rss = *pss = *uss = 0;
+}
+#endif
+
 union proc_op {
 	int (*proc_get_link)(struct inode *, struct path *);
 	int (*proc_read)(struct task_struct *task, char *page);
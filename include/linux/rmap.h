@@ -45,6 +45,13 @@ struct anon_vma {
 	 * mm_take_all_locks() (mm_all_locks_mutex).
 	 */
 	struct list_head head;	/* Chain of private "related" vmas */
+#ifdef CONFIG_SWAP
+	/*
+	 * Swap entry last allocated for one of its pages, so that the
+	 * next one goes right after it (see swap_locality). Only a hint.
+	 */
+	unsigned long swap_cursor;
+#endif
 };
 
 /*
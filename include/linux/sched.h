@@ -436,8 +436,10 @@ extern int get_dumpable(struct mm_struct *mm);
 					/* leave room for more dump flags */
 #define MMF_VM_MERGEABLE	16	/* KSM may merge identical pages */
 #define MMF_VM_HUGEPAGE		17	/* set when VM_HUGEPAGE is set on vma */
+#define MMF_VM_MERGE_ANY	18	/* KSM may merge any anonymous page */
 
-#define MMF_INIT_MASK		(MMF_DUMPABLE_MASK | MMF_DUMP_FILTER_MASK)
+#define MMF_INIT_MASK		(MMF_DUMPABLE_MASK | MMF_DUMP_FILTER_MASK | \
+				 (1 << MMF_VM_MERGE_ANY))
 
 struct sighand_struct {
 	atomic_t		count;
@@ -769,6 +771,7 @@ struct task_delay_info {
 	struct timespec freepages_start, freepages_end;
 	u64 freepages_delay;	/* wait for memory reclaim */
 	u32 freepages_count;	/* total count of memory reclaim */
+	u64 freepages_delay_max;	/* longest wait for memory reclaim */
 };
 #endif	/* CONFIG_TASK_DELAY_ACCT */
 
@@ -1104,6 +1107,12 @@ struct load_weight {
 };
 
 #ifdef CONFIG_SCHEDSTATS
+/*
+ * Wakeup to run latency histograms: bucket 0 counts the latencies below
+ * 1us, bucket n those in [2^(n-1), 2^n) usecs, the last one the rest.
+ */
+#define SCHED_LAT_BUCKETS	20
+
 struct sched_statistics {
 	u64			wait_start;
 	u64			wait_max;
@@ -1136,6 +1145,9 @@ struct sched_statistics {
 	u64			nr_wakeups_affine_attempts;
 	u64			nr_wakeups_passive;
 	u64			nr_wakeups_idle;
+
+	u64			wakeup_start;
+	unsigned int		wakeup_lat_hist[SCHED_LAT_BUCKETS];
 };
 #endif
 
@@ -1918,6 +1930,9 @@ extern unsigned int sysctl_sched_latency;
 extern unsigned int sysctl_sched_min_granularity;
 extern unsigned int sysctl_sched_wakeup_granularity;
 extern unsigned int sysctl_sched_child_runs_first;
+#ifdef CONFIG_SCHED_MM_SWITCH_COST
+extern unsigned int sysctl_sched_mm_switch_tolerance;
+#endif
 
 enum sched_tunable_scaling {
 	SCHED_TUNABLESCALING_NONE,
@@ -33,7 +33,7 @@
  */
 
 
-#define TASKSTATS_VERSION	8
+#define TASKSTATS_VERSION	10
 #define TS_COMM_LEN		32	/* should be >= TASK_COMM_LEN
 					 * in linux/sched.h */
 
@@ -163,6 +163,21 @@ struct taskstats {
 	/* Delay waiting for memory reclaim */
 	__u64	freepages_count;
 	__u64	freepages_delay_total;
+
+	/* Proportional and unique set sizes, in KB, if the kernel can
+	 * compute them (CONFIG_PROC_PAGE_MONITOR): each resident page
+	 * counts divided by the number of processes mapping it for pss,
+	 * and only if no other process maps it for uss. Only filled in
+	 * for TASKSTATS_CMD_GET queries by callers allowed to ptrace the
+	 * task, zero otherwise and in the exit records.
+	 */
+	__u64	pss;			/* Proportional set size, in KB */
+	__u64	uss;			/* Unique set size, in KB */
+	/* version 9 ends here */
+
+	/* Longest single wait for memory reclaim, in ns */
+	__u64	freepages_delay_max;
+	/* version 10 ends here */
 };
 
 
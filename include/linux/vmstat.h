@@ -64,6 +64,11 @@ enum vm_event_item { PGPGIN, PGPGOUT, PSWPIN, PSWPOUT,
 		THP_COLLAPSE_ALLOC,
 		THP_COLLAPSE_ALLOC_FAILED,
 		THP_SPLIT,
+#endif
+#ifdef CONFIG_READAHEAD_FEEDBACK
+		READAHEAD_PAGES,	/* pages read ahead */
+		READAHEAD_HIT,		/* accessed before being evicted */
+		READAHEAD_WASTE,	/* evicted without having been accessed */
 #endif
 		NR_VM_EVENT_ITEMS
 };
@@ -310,6 +310,64 @@ TRACE_EVENT(mm_vmscan_lru_shrink_inactive,
 		show_reclaim_flags(__entry->reclaim_flags))
 );
 
+TRACE_EVENT(mm_vmscan_direct_shrink_lru,
+
+	TP_PROTO(int nid, int zid, int lru,
+			unsigned long nr_reclaimed, u64 delta_ns),
+
+	TP_ARGS(nid, zid, lru, nr_reclaimed, delta_ns),
+
+	TP_STRUCT__entry(
+		__field(int, nid)
+		__field(int, zid)
+		__field(int, lru)
+		__field(unsigned long, nr_reclaimed)
+		__field(u64, delta_ns)
+	),
+
+	TP_fast_assign(
+		__entry->nid = nid;
+		__entry->zid = zid;
+		__entry->lru = lru;
+		__entry->nr_reclaimed = nr_reclaimed;
+		__entry->delta_ns = delta_ns;
+	),
+
+	TP_printk("nid=%d zid=%d lru=%s nr_reclaimed=%lu delta_ns=%llu",
+		__entry->nid, __entry->zid,
+		__print_symbolic(__entry->lru,
+			{LRU_INACTIVE_ANON,	"inactive_anon"},
+			{LRU_ACTIVE_ANON,	"active_anon"},
+			{LRU_INACTIVE_FILE,	"inactive_file"},
+			{LRU_ACTIVE_FILE,	"active_file"}),
+		__entry->nr_reclaimed,
+		(unsigned long long)__entry->delta_ns)
+);
+
+TRACE_EVENT(mm_vmscan_direct_shrink_slab,
+
+	TP_PROTO(struct shrinker *shrinker,
+			unsigned long nr_freed, u64 delta_ns),
+
+	TP_ARGS(shrinker, nr_freed, delta_ns),
+
+	TP_STRUCT__entry(
+		__field(void *, shrink)
+		__field(unsigned long, nr_freed)
+		__field(u64, delta_ns)
+	),
+
+	TP_fast_assign(
+		__entry->shrink = shrinker->shrink;
+		__entry->nr_freed = nr_freed;
+		__entry->delta_ns = delta_ns;
+	),
+
+	TP_printk("%pF nr_freed=%lu delta_ns=%llu",
+		__entry->shrink,
+		__entry->nr_freed,
+		(unsigned long long)__entry->delta_ns)
+);
 
 #endif /* _TRACE_VMSCAN_H */
 
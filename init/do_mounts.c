@@ -16,6 +16,7 @@
 #include <linux/async.h>
 #include <linux/fs_struct.h>
 #include <linux/slab.h>
+#include <linux/boot_profile.h>
 
 #include <linux/nfs_fs.h>
 #include <linux/nfs_fs_sb.h>
@@ -287,7 +288,11 @@ static void __init get_fs_names(char *page)
 
 static int __init do_mount_root(char *name, char *fs, int flags, void *data)
 {
+	u64 start = boot_profile_start();
 	int err = sys_mount(name, "/root", fs, flags, data);
+
+	/* One record per filesystem type tried */
+	boot_profile_record(BOOT_PROFILE_MOUNT_ROOT, NULL, fs, start, err);
 	if (err)
 		return err;
 
@@ -8,6 +8,8 @@
 #include <linux/dirent.h>
 #include <linux/syscalls.h>
 #include <linux/utime.h>
+#include <linux/async.h>
+#include <linux/boot_profile.h>
 
 static __initdata char *message;
 static void __init error(char *x)
@@ -415,8 +417,9 @@ static char * __init unpack_to_rootfs(char *buf, unsigned len)
 {
 	int written, res;
 	decompress_fn decompress;
-	const char *compress_name;
+	const char *compress_name = NULL;
 	static __initdata char msg_buf[64];
+	u64 start = boot_profile_start();
 
 	header_buf = kmalloc(110, GFP_KERNEL);
 	symlink_buf = kmalloc(PATH_MAX + N_ALIGN(PATH_MAX) + 1, GFP_KERNEL);
@@ -469,6 +472,10 @@ static char * __init unpack_to_rootfs(char *buf, unsigned len)
 	kfree(name_buf);
 	kfree(symlink_buf);
 	kfree(header_buf);
+	/* Named after the (last) compression method of the archive */
+	boot_profile_record(BOOT_PROFILE_INITRAMFS, NULL,
+			    compress_name ? compress_name : "cpio", start,
+			    message ? -EINVAL : 0);
 	return message;
 }
 
@@ -569,7 +576,7 @@ static void __init clean_rootfs(void)
 }
 #endif
 
-static int __init populate_rootfs(void)
+static void __init do_populate_rootfs(void *unused, async_cookie_t cookie)
 {
 	char *err = unpack_to_rootfs(__initramfs_start, __initramfs_size);
 	if (err)
@@ -582,7 +589,7 @@ static int __init populate_rootfs(void)
 			initrd_end - initrd_start);
 		if (!err) {
 			free_initrd();
-			return 0;
+			return;
 		} else {
 			clean_rootfs();
 			unpack_to_rootfs(__initramfs_start, __initramfs_size);
@@ -606,6 +613,41 @@ static int __init populate_rootfs(void)
 		free_initrd();
 #endif
 	}
+}
+
+static int __initdata initramfs_async = 1;
+
+static int __init initramfs_async_setup(char *str)
+{
+	initramfs_async = simple_strtol(str, NULL, 0) != 0;
+	return 1;
+}
+__setup("initramfs_async=", initramfs_async_setup);
+
+/* Not __initdata: usermode helpers wait for the unpacking too */
+static LIST_HEAD(initramfs_domain);
+
+/*
+ * Wait for the initramfs to be unpacked: anything which looks for files
+ * in the rootfs, or runs programs from it, has to call this first.
+ */
+void wait_for_initramfs(void)
+{
+	async_synchronize_full_domain(&initramfs_domain);
+}
+
+/*
+ * Unpacking, and decompressing, the initramfs is slow and only the
+ * rootfs needs it, so by default it runs alongside the following
+ * initcalls.
+ */
+static int __init populate_rootfs(void)
+{
+	if (initramfs_async)
+		async_schedule_domain(do_populate_rootfs, NULL,
+				      &initramfs_domain);
+	else
+		do_populate_rootfs(NULL, 0);
 	return 0;
 }
 rootfs_initcall(populate_rootfs);
@@ -68,6 +68,8 @@
 #include <linux/shmem_fs.h>
 #include <linux/slab.h>
 #include <linux/perf_event.h>
+#include <linux/boot_prefetch.h>
+#include <linux/boot_profile.h>
 
 #include <asm/io.h>
 #include <asm/bugs.h>
@@ -662,12 +664,14 @@ static int __init_or_module do_one_initcall_debug(initcall_t fn)
 int __init_or_module do_one_initcall(initcall_t fn)
 {
 	int count = preempt_count();
+	u64 start = boot_profile_start();
 	int ret;
 
 	if (initcall_debug)
 		ret = do_one_initcall_debug(fn);
 	else
 		ret = fn();
+	boot_profile_record(BOOT_PROFILE_INITCALL, fn, NULL, start, ret);
 
 	msgbuf[0] = 0;
 
@@ -726,9 +730,13 @@ static void __init do_pre_smp_initcalls(void)
 		do_one_initcall(*fn);
 }
 
+static u64 init_post_start;
+
 static void run_init_process(const char *init_filename)
 {
 	argv_init[0] = init_filename;
+	/* Made before each attempt: the last one is the init which ran */
+	boot_profile_init_exec(init_filename, init_post_start);
 	kernel_execve(init_filename, argv_init, envp_init);
 }
 
@@ -737,6 +745,8 @@ static void run_init_process(const char *init_filename)
  */
 static noinline int init_post(void)
 {
+	init_post_start = boot_profile_start();
+
 	/* need to finish all async __init code before freeing the memory */
 	async_synchronize_full();
 	free_initmem();
@@ -800,6 +810,8 @@ static int __init kernel_init(void * unused)
 
 	do_basic_setup();
 
+	wait_for_initramfs();
+
 	/* Open the /dev/console on the rootfs, this should never fail */
 	if (sys_open((const char __user *) "/dev/console", O_RDWR, 0) < 0)
 		printk(KERN_WARNING "Warning: unable to open an initial console.\n");
@@ -817,6 +829,8 @@ static int __init kernel_init(void * unused)
 	if (sys_access((const char __user *) ramdisk_execute_command, 0) != 0) {
 		ramdisk_execute_command = NULL;
 		prepare_namespace();
+		/* Not with an initramfs, which mounts the real root itself */
+		boot_prefetch_start();
 	}
 
 	/*
@@ -21,6 +21,7 @@
 #include <linux/stat.h>
 #include <linux/kdev_t.h>
 #include <linux/syscalls.h>
+#include <linux/initrd.h>
 
 /*
  * Create a simple rootfs that is similar to the default initramfs
@@ -50,3 +51,8 @@ out:
 	return err;
 }
 rootfs_initcall(default_rootfs);
+
+/* The default rootfs is created synchronously */
+void wait_for_initramfs(void)
+{
+}
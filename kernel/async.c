@@ -49,6 +49,7 @@ asynchronous and synchronous parts of the kernel.
 */
 
 #include <linux/async.h>
+#include <linux/boot_profile.h>
 #include <linux/module.h>
 #include <linux/wait.h>
 #include <linux/sched.h>
@@ -120,6 +121,7 @@ static void async_run_entry_fn(struct work_struct *work)
 		container_of(work, struct async_entry, work);
 	unsigned long flags;
 	ktime_t calltime, delta, rettime;
+	u64 start;
 
 	/* 1) move self to the running queue */
 	spin_lock_irqsave(&async_lock, flags);
@@ -132,7 +134,9 @@ static void async_run_entry_fn(struct work_struct *work)
 			entry->func, task_pid_nr(current));
 		calltime = ktime_get();
 	}
+	start = boot_profile_start();
 	entry->func(entry->data, entry->cookie);
+	boot_profile_record(BOOT_PROFILE_ASYNC, entry->func, NULL, start, 0);
 	if (initcall_debug && system_state == SYSTEM_BOOTING) {
 		rettime = ktime_get();
 		delta = ktime_sub(rettime, calltime);
@@ -0,0 +1,198 @@
+/*
+ * Boot profile
+ *
+ * Records how long the initcalls, driver probes, async functions, the
+ * initramfs unpacking and the root mount take, and when init is started,
+ * in a fixed size buffer which debugfs exports as "boot_profile", one
+ * record per line:
+ *
+ *	<event> <start_us> <duration_us> <ret> <pid> <name>
+ *
+ * Times are in microseconds since the scheduler clock started. Recording
+ * stops when init is executed. Records which don't fit in the buffer are
+ * dropped, so that the start of the boot is kept, and counted on the last
+ * line.
+ */
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/boot_profile.h>
+#include <linux/debugfs.h>
+#include <linux/module.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/string.h>
+#include <asm/atomic.h>
+
+#define BOOT_PROFILE_NAME_LEN	32
+
+struct boot_profile_rec {
+	u64 start;		/* ns */
+	u64 duration;		/* ns */
+	const void *fn;		/* only if in the core kernel */
+	char name[BOOT_PROFILE_NAME_LEN];
+	int ret;
+	pid_t pid;
+	u8 event;
+	u8 valid;		/* set once the record is complete */
+};
+
+static const char * const boot_profile_events[BOOT_PROFILE_NR_EVENTS] = {
+	[BOOT_PROFILE_INITCALL]		= "initcall",
+	[BOOT_PROFILE_PROBE]		= "probe",
+	[BOOT_PROFILE_ASYNC]		= "async",
+	[BOOT_PROFILE_INITRAMFS]	= "initramfs",
+	[BOOT_PROFILE_MOUNT_ROOT]	= "mount_root",
+	[BOOT_PROFILE_INIT_EXEC]	= "init_exec",
+};
+
+static struct boot_profile_rec boot_profile_recs[CONFIG_BOOT_PROFILE_RECORDS];
+static atomic_t boot_profile_next = ATOMIC_INIT(0);
+static atomic_t boot_profile_dropped = ATOMIC_INIT(0);
+static int boot_profile_disabled;
+int boot_profile_recording = 1;
+
+static int __init boot_profile_setup(char *str)
+{
+	boot_profile_disabled = 1;
+	boot_profile_recording = 0;
+	return 1;
+}
+__setup("no_boot_profile", boot_profile_setup);
+
+u64 __boot_profile_clock(void)
+{
+	return local_clock();
+}
+
+void __boot_profile_record(enum boot_profile_event event, const void *fn,
+			   const char *name, u64 start, int ret)
+{
+	struct boot_profile_rec *rec;
+	u64 now = local_clock();
+	int i;
+
+	i = atomic_inc_return(&boot_profile_next) - 1;
+	if (i >= CONFIG_BOOT_PROFILE_RECORDS) {
+		atomic_inc(&boot_profile_dropped);
+		return;
+	}
+
+	rec = &boot_profile_recs[i];
+	rec->start = start;
+	rec->duration = now - start;
+	/*
+	 * The init function of a module is gone by the time the record is
+	 * read: keep the name of the module instead.
+	 */
+	if (fn && !core_kernel_text((unsigned long)fn)) {
+		struct module *mod;
+
+		preempt_disable();
+		mod = __module_text_address((unsigned long)fn);
+		if (mod)
+			strlcpy(rec->name, mod->name, sizeof(rec->name));
+		preempt_enable();
+		fn = NULL;
+	} else if (!fn && name) {
+		strlcpy(rec->name, name, sizeof(rec->name));
+	}
+	rec->fn = fn;
+	rec->ret = ret;
+	rec->pid = task_pid_nr(current);
+	rec->event = event;
+	smp_wmb();
+	rec->valid = 1;
+}
+
+/*
+ * The exec of init ends the boot: nothing is recorded after the first
+ * attempt, except the attempts to exec another init if it fails.
+ */
+void boot_profile_init_exec(const char *name, u64 start)
+{
+	if (boot_profile_disabled)
+		return;
+	boot_profile_recording = 0;
+	__boot_profile_record(BOOT_PROFILE_INIT_EXEC, NULL, name, start, 0);
+}
+
+static unsigned int boot_profile_nr_recs(void)
+{
+	return min(atomic_read(&boot_profile_next),
+		   CONFIG_BOOT_PROFILE_RECORDS);
+}
+
+static void *boot_profile_seq_start(struct seq_file *m, loff_t *pos)
+{
+	/* One more position for the trailer */
+	if (*pos > boot_profile_nr_recs())
+		return NULL;
+	return pos;
+}
+
+static void *boot_profile_seq_next(struct seq_file *m, void *v, loff_t *pos)
+{
+	++*pos;
+	return boot_profile_seq_start(m, pos);
+}
+
+static void boot_profile_seq_stop(struct seq_file *m, void *v)
+{
+}
+
+static int boot_profile_seq_show(struct seq_file *m, void *v)
+{
+	loff_t i = *(loff_t *)v;
+	struct boot_profile_rec *rec;
+
+	if (i == 0)
+		seq_puts(m, "# event start_us duration_us ret pid name\n");
+
+	if (i == boot_profile_nr_recs()) {
+		seq_printf(m, "# dropped %d\n",
+			   atomic_read(&boot_profile_dropped));
+		return 0;
+	}
+
+	rec = &boot_profile_recs[i];
+	if (!rec->valid)
+		return 0;
+	smp_rmb();
+
+	seq_printf(m, "%s %llu %llu %d %d ", boot_profile_events[rec->event],
+		   div_u64(rec->start, NSEC_PER_USEC),
+		   div_u64(rec->duration, NSEC_PER_USEC), rec->ret, rec->pid);
+	if (rec->fn)
+		seq_printf(m, "%pf\n", rec->fn);
+	else
+		seq_printf(m, "%s\n", rec->name[0] ? rec->name : "-");
+	return 0;
+}
+
+static const struct seq_operations boot_profile_seq_ops = {
+	.start	= boot_profile_seq_start,
+	.next	= boot_profile_seq_next,
+	.stop	= boot_profile_seq_stop,
+	.show	= boot_profile_seq_show,
+};
+
+static int boot_profile_open(struct inode *inode, struct file *file)
+{
+	return seq_open(file, &boot_profile_seq_ops);
+}
+
+static const struct file_operations boot_profile_fops = {
+	.open		= boot_profile_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= seq_release,
+};
+
+static int __init boot_profile_debugfs_init(void)
+{
+	debugfs_create_file("boot_profile", S_IRUSR, NULL, NULL,
+			    &boot_profile_fops);
+	return 0;
+}
+late_initcall(boot_profile_debugfs_init);
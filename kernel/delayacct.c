@@ -55,10 +55,11 @@ static inline void delayacct_start(struct timespec *start)
 
 /*
  * Finish delay accounting for a statistic using
- * its timestamps (@start, @end), accumalator (@total) and @count
+ * its timestamps (@start, @end), accumalator (@total) and @count.
+ * Returns the delay, in ns.
  */
 
-static void delayacct_end(struct timespec *start, struct timespec *end,
+static s64 delayacct_end(struct timespec *start, struct timespec *end,
 				u64 *total, u32 *count)
 {
 	struct timespec ts;
@@ -69,12 +70,14 @@ static void delayacct_end(struct timespec *start, struct timespec *end,
 	ts = timespec_sub(*end, *start);
 	ns = timespec_to_ns(&ts);
 	if (ns < 0)
-		return;
+		return 0;
 
 	spin_lock_irqsave(&current->delays->lock, flags);
 	*total += ns;
 	(*count)++;
 	spin_unlock_irqrestore(&current->delays->lock, flags);
+
+	return ns;
 }
 
 void __delayacct_blkio_start(void)
@@ -151,6 +154,8 @@ int __delayacct_add_tsk(struct taskstats *d, struct task_struct *tsk)
 	d->blkio_count += tsk->delays->blkio_count;
 	d->swapin_count += tsk->delays->swapin_count;
 	d->freepages_count += tsk->delays->freepages_count;
+	d->freepages_delay_max = max(d->freepages_delay_max,
+				     tsk->delays->freepages_delay_max);
 	spin_unlock_irqrestore(&tsk->delays->lock, flags);
 
 done:
@@ -176,9 +181,17 @@ void __delayacct_freepages_start(void)
 
 void __delayacct_freepages_end(void)
 {
-	delayacct_end(&current->delays->freepages_start,
+	s64 ns;
+	unsigned long flags;
+
+	ns = delayacct_end(&current->delays->freepages_start,
 			&current->delays->freepages_end,
 			&current->delays->freepages_delay,
 			&current->delays->freepages_count);
+
+	spin_lock_irqsave(&current->delays->lock, flags);
+	if (ns > current->delays->freepages_delay_max)
+		current->delays->freepages_delay_max = ns;
+	spin_unlock_irqrestore(&current->delays->lock, flags);
 }
 
@@ -45,6 +45,8 @@
 #include <linux/debugobjects.h>
 #include <linux/sched.h>
 #include <linux/timer.h>
+#include <linux/debugfs.h>
+#include <linux/mutex.h>
 
 #include <asm/uaccess.h>
 
@@ -1019,6 +1021,99 @@ hrtimer_start(struct hrtimer *timer, ktime_t tim, const enum hrtimer_mode mode)
 }
 EXPORT_SYMBOL_GPL(hrtimer_start);
 
+static DEFINE_MUTEX(hrtimer_classes_mutex);
+static LIST_HEAD(hrtimer_classes);
+
+/**
+ * hrtimer_class_register - make a timer class tunable
+ * @class:	the class, usually defined with DEFINE_HRTIMER_CLASS()
+ *
+ * The coalescing window of a registered class can be changed in
+ * debugfs "hrtimer_classes", by writing "<name> <slack_ns>" to it.
+ * Classes can be used without being registered.
+ */
+void hrtimer_class_register(struct hrtimer_class *class)
+{
+	mutex_lock(&hrtimer_classes_mutex);
+	list_add_tail(&class->list, &hrtimer_classes);
+	mutex_unlock(&hrtimer_classes_mutex);
+}
+EXPORT_SYMBOL_GPL(hrtimer_class_register);
+
+void hrtimer_class_unregister(struct hrtimer_class *class)
+{
+	mutex_lock(&hrtimer_classes_mutex);
+	list_del_init(&class->list);
+	mutex_unlock(&hrtimer_classes_mutex);
+}
+EXPORT_SYMBOL_GPL(hrtimer_class_unregister);
+
+#ifdef CONFIG_DEBUG_FS
+static int hrtimer_classes_show(struct seq_file *m, void *v)
+{
+	struct hrtimer_class *class;
+
+	mutex_lock(&hrtimer_classes_mutex);
+	list_for_each_entry(class, &hrtimer_classes, list)
+		seq_printf(m, "%s %lu\n", class->name, class->slack_ns);
+	mutex_unlock(&hrtimer_classes_mutex);
+
+	return 0;
+}
+
+static int hrtimer_classes_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, hrtimer_classes_show, NULL);
+}
+
+static ssize_t hrtimer_classes_write(struct file *file,
+				     const char __user *ubuf,
+				     size_t count, loff_t *ppos)
+{
+	struct hrtimer_class *class;
+	char buf[64], name[48];
+	unsigned long slack_ns;
+	int ret = -EINVAL;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	if (sscanf(buf, "%47s %lu", name, &slack_ns) != 2)
+		return -EINVAL;
+
+	mutex_lock(&hrtimer_classes_mutex);
+	list_for_each_entry(class, &hrtimer_classes, list) {
+		if (!strcmp(class->name, name)) {
+			class->slack_ns = slack_ns;
+			ret = count;
+			break;
+		}
+	}
+	mutex_unlock(&hrtimer_classes_mutex);
+
+	return ret;
+}
+
+static const struct file_operations hrtimer_classes_fops = {
+	.open		= hrtimer_classes_open,
+	.read		= seq_read,
+	.write		= hrtimer_classes_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init hrtimer_classes_debugfs_init(void)
+{
+	debugfs_create_file("hrtimer_classes", S_IRUGO | S_IWUSR, NULL, NULL,
+			    &hrtimer_classes_fops);
+	return 0;
+}
+late_initcall(hrtimer_classes_debugfs_init);
+#endif /* CONFIG_DEBUG_FS */
+
 
 /**
  * hrtimer_try_to_cancel - try to deactivate a timer
@@ -1292,6 +1387,8 @@ retry:
 				break;
 			}
 
+			if (basenow.tv64 < hrtimer_get_expires_tv64(timer))
+				cpu_base->nr_coalesced++;
 			__run_hrtimer(timer, &basenow);
 		}
 		base++;
@@ -1447,8 +1544,13 @@ void hrtimer_run_queues(void)
 			struct hrtimer *timer;
 
 			timer = container_of(node, struct hrtimer, node);
-			if (base->softirq_time.tv64 <=
-					hrtimer_get_expires_tv64(timer))
+			/*
+			 * As in hrtimer_interrupt(), run the timers which
+			 * have reached their soft expiry time, so that
+			 * they don't need a tick of their own later.
+			 */
+			if (base->softirq_time.tv64 <
+					hrtimer_get_softexpires_tv64(timer))
 				break;
 
 			__run_hrtimer(timer, &base->softirq_time);
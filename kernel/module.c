@@ -57,6 +57,7 @@
 #include <linux/kmemleak.h>
 #include <linux/jump_label.h>
 #include <linux/pfn.h>
+#include <linux/bsearch.h>
 
 #define CREATE_TRACE_POINTS
 #include <trace/events/module.h>
@@ -111,6 +112,10 @@ struct list_head *kdb_modules = &modules; /* kdb needs the list of modules */
 /* Block module loading/unloading? */
 int modules_disabled = 0;
 
+/* Report how long each phase of load_module() takes? */
+static bool load_timing;
+module_param(load_timing, bool, 0644);
+
 /* Waiting for a module to finish initializing? */
 static DECLARE_WAIT_QUEUE_HEAD(module_wq);
 
@@ -132,6 +137,21 @@ int unregister_module_notifier(struct notifier_block * nb)
 }
 EXPORT_SYMBOL(unregister_module_notifier);
 
+/* Phases of load_module(), timed with module.load_timing=1 */
+enum load_phase {
+	LOAD_COPY,		/* copy from userspace, sanity checks */
+	LOAD_LAYOUT,		/* section layout and allocation */
+	LOAD_SYMBOLS,		/* resolution of undefined symbols */
+	LOAD_RELOCATE,
+	LOAD_FINALIZE,		/* arch finalizing, kallsyms */
+	LOAD_LINK,		/* list, arguments and sysfs */
+	LOAD_NR_PHASES
+};
+
+static const char * const load_phase_names[LOAD_NR_PHASES] = {
+	"copy", "layout", "symbols", "relocate", "finalize", "link",
+};
+
 struct load_info {
 	Elf_Ehdr *hdr;
 	unsigned long len;
@@ -144,6 +164,8 @@ struct load_info {
 	struct {
 		unsigned int sym, str, mod, vers, info, pcpu;
 	} index;
+	u64 phase_start;
+	u64 phase_ns[LOAD_NR_PHASES];
 };
 
 /* We require a truly strong try_module_get(): 0 means failure due to
@@ -235,28 +257,11 @@ extern const unsigned long __start___kcrctab_unused_gpl[];
 #define symversion(base, idx) ((base != NULL) ? ((base) + (idx)) : NULL)
 #endif
 
-static bool each_symbol_in_section(const struct symsearch *arr,
-				   unsigned int arrsize,
-				   struct module *owner,
-				   bool (*fn)(const struct symsearch *syms,
-					      struct module *owner,
-					      unsigned int symnum, void *data),
-				   void *data)
-{
-	unsigned int i, j;
-
-	for (j = 0; j < arrsize; j++) {
-		for (i = 0; i < arr[j].stop - arr[j].start; i++)
-			if (fn(&arr[j], owner, i, data))
-				return true;
-	}
-
-	return false;
-}
-
 /* Returns true as soon as fn returns true, otherwise false. */
-bool each_symbol(bool (*fn)(const struct symsearch *arr, struct module *owner,
-			    unsigned int symnum, void *data), void *data)
+bool each_symbol_section(bool (*fn)(const struct symsearch *arr,
+				    struct module *owner,
+				    void *data),
+			 void *data)
 {
 	struct module *mod;
 	static const struct symsearch arr[] = {
@@ -277,9 +282,11 @@ bool each_symbol(bool (*fn)(const struct symsearch *arr, struct module *owner,
 		  GPL_ONLY, true },
 #endif
 	};
+	unsigned int i;
 
-	if (each_symbol_in_section(arr, ARRAY_SIZE(arr), NULL, fn, data))
-		return true;
+	for (i = 0; i < ARRAY_SIZE(arr); i++)
+		if (fn(&arr[i], NULL, data))
+			return true;
 
 	list_for_each_entry_rcu(mod, &modules, list) {
 		struct symsearch arr[] = {
@@ -304,11 +311,40 @@ bool each_symbol(bool (*fn)(const struct symsearch *arr, struct module *owner,
 #endif
 		};
 
-		if (each_symbol_in_section(arr, ARRAY_SIZE(arr), mod, fn, data))
-			return true;
+		for (i = 0; i < ARRAY_SIZE(arr); i++)
+			if (fn(&arr[i], mod, data))
+				return true;
 	}
 	return false;
 }
+EXPORT_SYMBOL_GPL(each_symbol_section);
+
+struct each_symbol_arg {
+	bool (*fn)(const struct symsearch *arr, struct module *owner,
+		   unsigned int symnum, void *data);
+	void *data;
+};
+
+static bool each_symbol_in_section(const struct symsearch *syms,
+				   struct module *owner, void *data)
+{
+	struct each_symbol_arg *esa = data;
+	unsigned int i;
+
+	for (i = 0; i < syms->stop - syms->start; i++)
+		if (esa->fn(syms, owner, i, esa->data))
+			return true;
+	return false;
+}
+
+/* Returns true as soon as fn returns true, otherwise false. */
+bool each_symbol(bool (*fn)(const struct symsearch *arr, struct module *owner,
+			    unsigned int symnum, void *data), void *data)
+{
+	struct each_symbol_arg esa = { fn, data };
+
+	return each_symbol_section(each_symbol_in_section, &esa);
+}
 EXPORT_SYMBOL_GPL(each_symbol);
 
 struct find_symbol_arg {
@@ -323,15 +359,12 @@ struct find_symbol_arg {
 	const struct kernel_symbol *sym;
 };
 
-static bool find_symbol_in_section(const struct symsearch *syms,
-				   struct module *owner,
-				   unsigned int symnum, void *data)
+static bool check_symbol(const struct symsearch *syms,
+			 struct module *owner,
+			 unsigned int symnum, void *data)
 {
 	struct find_symbol_arg *fsa = data;
 
-	if (strcmp(syms->start[symnum].name, fsa->name) != 0)
-		return false;
-
 	if (!fsa->gplok) {
 		if (syms->licence == GPL_ONLY)
 			return false;
@@ -365,6 +398,31 @@ static bool find_symbol_in_section(const struct symsearch *syms,
 	return true;
 }
 
+static int cmp_name(const void *name, const void *sym)
+{
+	return strcmp(name, ((const struct kernel_symbol *)sym)->name);
+}
+
+/*
+ * The export tables are sorted by name at link time (see
+ * include/asm-generic/vmlinux.lds.h and scripts/module-common.lds).
+ */
+static bool find_symbol_in_section(const struct symsearch *syms,
+				   struct module *owner,
+				   void *data)
+{
+	struct find_symbol_arg *fsa = data;
+	const struct kernel_symbol *sym;
+
+	sym = bsearch(fsa->name, syms->start, syms->stop - syms->start,
+			sizeof(struct kernel_symbol), cmp_name);
+
+	if (sym != NULL && check_symbol(syms, owner, sym - syms->start, data))
+		return true;
+
+	return false;
+}
+
 /* Find a symbol and return it, along with, (optional) crc and
  * (optional) module which owns it.  Needs preempt disabled or module_mutex. */
 const struct kernel_symbol *find_symbol(const char *name,
@@ -379,7 +437,7 @@ const struct kernel_symbol *find_symbol(const char *name,
 	fsa.gplok = gplok;
 	fsa.warn = warn;
 
-	if (each_symbol(find_symbol_in_section, &fsa)) {
+	if (each_symbol_section(find_symbol_in_section, &fsa)) {
 		if (owner)
 			*owner = fsa.owner;
 		if (crc)
@@ -2030,11 +2088,8 @@ static const struct kernel_symbol *lookup_symbol(const char *name,
 	const struct kernel_symbol *start,
 	const struct kernel_symbol *stop)
 {
-	const struct kernel_symbol *ks = start;
-	for (; ks < stop; ks++)
-		if (strcmp(ks->name, name) == 0)
-			return ks;
-	return NULL;
+	return bsearch(name, start, stop - start,
+			sizeof(struct kernel_symbol), cmp_name);
 }
 
 static int is_exported(const char *name, unsigned long value,
@@ -2710,6 +2765,38 @@ static int post_relocation(struct module *mod, const struct load_info *info)
 	return module_finalize(info->hdr, info->sechdrs, mod);
 }
 
+static void load_phase_done(struct load_info *info, enum load_phase phase)
+{
+	u64 now;
+
+	if (!load_timing)
+		return;
+
+	now = local_clock();
+	info->phase_ns[phase] = now - info->phase_start;
+	info->phase_start = now;
+}
+
+static void load_timing_report(struct module *mod, struct load_info *info)
+{
+	char buf[128];
+	int i, len = 0;
+	u64 total = 0;
+
+	if (!load_timing)
+		return;
+
+	for (i = 0; i < LOAD_NR_PHASES; i++) {
+		len += scnprintf(buf + len, sizeof(buf) - len, " %s %llu",
+				 load_phase_names[i],
+				 div_u64(info->phase_ns[i], NSEC_PER_USEC));
+		total += info->phase_ns[i];
+	}
+
+	printk(KERN_INFO "%s: loaded in %llu us:%s\n", mod->name,
+	       div_u64(total, NSEC_PER_USEC), buf);
+}
+
 /* Allocate and load the module: note that size of section 0 is always
    zero, and we rely on this for optional sections. */
 static struct module *load_module(void __user *umod,
@@ -2723,10 +2810,14 @@ static struct module *load_module(void __user *umod,
 	DEBUGP("load_module: umod=%p, len=%lu, uargs=%p\n",
 	       umod, len, uargs);
 
+	if (load_timing)
+		info.phase_start = local_clock();
+
 	/* Copy in the blobs from userspace, check they are vaguely sane. */
 	err = copy_and_check(&info, umod, len, uargs);
 	if (err)
 		return ERR_PTR(err);
+	load_phase_done(&info, LOAD_COPY);
 
 	/* Figure out module layout, and allocate all the memory. */
 	mod = layout_and_allocate(&info);
@@ -2750,15 +2841,18 @@ static struct module *load_module(void __user *umod,
 
 	/* Set up MODINFO_ATTR fields */
 	setup_modinfo(mod, &info);
+	load_phase_done(&info, LOAD_LAYOUT);
 
 	/* Fix up syms, so that st_value is a pointer to location. */
 	err = simplify_symbols(mod, &info);
 	if (err < 0)
 		goto free_modinfo;
+	load_phase_done(&info, LOAD_SYMBOLS);
 
 	err = apply_relocations(mod, &info);
 	if (err < 0)
 		goto free_modinfo;
+	load_phase_done(&info, LOAD_RELOCATE);
 
 	err = post_relocation(mod, &info);
 	if (err < 0)
@@ -2773,6 +2867,8 @@ static struct module *load_module(void __user *umod,
 		goto free_arch_cleanup;
 	}
 
+	load_phase_done(&info, LOAD_FINALIZE);
+
 	/* Mark state as coming so strong_try_module_get() ignores us. */
 	mod->state = MODULE_STATE_COMING;
 
@@ -2815,6 +2911,8 @@ static struct module *load_module(void __user *umod,
 	/* Get rid of temporary copy and strmap. */
 	kfree(info.strmap);
 	free_copy(&info);
+	load_phase_done(&info, LOAD_LINK);
+	load_timing_report(mod, &info);
 
 	/* Done! */
 	trace_module_load(mod);
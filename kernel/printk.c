@@ -38,6 +38,7 @@
 #include <linux/kmsg_dump.h>
 #include <linux/syslog.h>
 #include <linux/cpu.h>
+#include <linux/kthread.h>
 #include <linux/notifier.h>
 #include <linux/rculist.h>
 
@@ -141,6 +142,12 @@ EXPORT_SYMBOL(console_set_on_cmdline);
 /* Flag: console code may call schedule() */
 static int console_may_schedule;
 
+/* Work left for printk_tick(), which runs where it is safe to wake tasks */
+#define PRINTK_PENDING_KLOGD	0x01
+#define PRINTK_PENDING_CONSOLE	0x02
+
+static DEFINE_PER_CPU(int, printk_pending);
+
 #ifdef CONFIG_PRINTK
 
 static char __log_buf[__LOG_BUF_LEN];
@@ -774,6 +781,105 @@ static int console_trylock_for_printk(unsigned int cpu)
 	spin_unlock(&logbuf_lock);
 	return retval;
 }
+#ifdef CONFIG_PRINTK_DEFERRED_CONSOLE
+/*
+ * Unless printk.synchronous is set, printk() only stores messages in
+ * log_buf, and kconsoled writes them to the consoles later, one line at a
+ * time, so that printing costs a copy rather than waiting for a slow
+ * console. Messages of level KERN_CRIT and above, and everything printed
+ * once an oops is in progress, still go to the consoles synchronously.
+ */
+static struct task_struct *console_thread;
+static int printk_synchronous;
+module_param_named(synchronous, printk_synchronous, bool, S_IRUGO | S_IWUSR);
+
+static inline int printk_defer_console(int level)
+{
+	return console_thread && !printk_synchronous && !oops_in_progress &&
+		level > 2;
+}
+
+/*
+ * Write the next line of log_buf to the consoles, with the interrupts only
+ * disabled for that line. The console_lock must be held.
+ */
+static void console_flush_line(void)
+{
+	unsigned long flags;
+	unsigned start, end;
+
+	spin_lock_irqsave(&logbuf_lock, flags);
+	start = end = con_start;
+	while (end != log_end)
+		if (LOG_BUF(end++) == '\n')
+			break;
+	con_start = end;
+	spin_unlock(&logbuf_lock);
+	stop_critical_timings();	/* don't trace print latency */
+	call_console_drivers(start, end);
+	start_critical_timings();
+	local_irq_restore(flags);
+}
+
+static int console_thread_fn(void *unused)
+{
+	for (;;) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		/* resume_console() wakes us up again */
+		if (con_start == log_end || console_suspended)
+			schedule();
+		__set_current_state(TASK_RUNNING);
+
+		while (con_start != log_end) {
+			/*
+			 * Drop the console_lock after each line, so that an
+			 * oops can take it and print without waiting for us.
+			 */
+			console_lock();
+			if (console_suspended) {
+				up(&console_sem);
+				cond_resched();
+				break;
+			}
+			console_flush_line();
+			console_locked = 0;
+			up(&console_sem);
+			cond_resched();
+		}
+		wake_up_klogd();
+	}
+
+	return 0;
+}
+
+static int __init console_thread_init(void)
+{
+	struct task_struct *tsk;
+
+	tsk = kthread_run(console_thread_fn, NULL, "kconsoled");
+	if (IS_ERR(tsk))
+		return PTR_ERR(tsk);
+	console_thread = tsk;
+	return 0;
+}
+early_initcall(console_thread_init);
+
+static void wake_up_console_thread(void)
+{
+	if (console_thread)
+		wake_up_process(console_thread);
+}
+#else
+static inline int printk_defer_console(int level)
+{
+	return 0;
+}
+
+static inline void wake_up_console_thread(void)
+{
+}
+#endif /* CONFIG_PRINTK_DEFERRED_CONSOLE */
+
 static const char recursion_bug_msg [] =
 		KERN_CRIT "BUG: recent printk recursion!\n";
 static int recursion_bug;
@@ -914,6 +1020,17 @@ asmlinkage int vprintk(const char *fmt, va_list args)
 			new_text_line = 1;
 	}
 
+	/*
+	 * Leave the output to kconsoled, which printk_tick() wakes up: we
+	 * may be called with scheduler locks held.
+	 */
+	if (printk_defer_console(current_log_level)) {
+		printk_cpu = UINT_MAX;
+		spin_unlock(&logbuf_lock);
+		this_cpu_or(printk_pending, PRINTK_PENDING_CONSOLE);
+		goto out;
+	}
+
 	/*
 	 * Try to acquire and then immediately release the
 	 * console semaphore. The release will do all the
@@ -926,6 +1043,7 @@ asmlinkage int vprintk(const char *fmt, va_list args)
 	 */
 	if (console_trylock_for_printk(this_cpu))
 		console_unlock();
+out:
 
 	lockdep_on();
 out_restore_irqs:
@@ -943,6 +1061,10 @@ static void call_console_drivers(unsigned start, unsigned end)
 {
 }
 
+static inline void wake_up_console_thread(void)
+{
+}
+
 #endif
 
 static int __add_preferred_console(char *name, int idx, char *options,
@@ -1098,6 +1220,7 @@ void resume_console(void)
 	down(&console_sem);
 	console_suspended = 0;
 	console_unlock();
+	wake_up_console_thread();
 }
 
 /**
@@ -1172,13 +1295,16 @@ int is_console_locked(void)
 	return console_locked;
 }
 
-static DEFINE_PER_CPU(int, printk_pending);
-
 void printk_tick(void)
 {
-	if (__this_cpu_read(printk_pending)) {
+	int pending = __this_cpu_read(printk_pending);
+
+	if (pending) {
 		__this_cpu_write(printk_pending, 0);
-		wake_up_interruptible(&log_wait);
+		if (pending & PRINTK_PENDING_KLOGD)
+			wake_up_interruptible(&log_wait);
+		if (pending & PRINTK_PENDING_CONSOLE)
+			wake_up_console_thread();
 	}
 }
 
@@ -1192,7 +1318,7 @@ int printk_needs_cpu(int cpu)
 void wake_up_klogd(void)
 {
 	if (waitqueue_active(&log_wait))
-		this_cpu_write(printk_pending, 1);
+		this_cpu_or(printk_pending, PRINTK_PENDING_KLOGD);
 }
 
 /**
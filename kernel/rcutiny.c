@@ -42,6 +42,16 @@ static DECLARE_WAIT_QUEUE_HEAD(rcu_kthread_wq);
 static unsigned long have_rcu_kthread_work;
 static void invoke_rcu_kthread(void);
 
+/*
+ * rcu_kthread() invokes at most blimit callbacks per pass, leaving the CPU
+ * to others for a tick before the next, unless more than qhimark are
+ * pending.
+ */
+static int blimit = 100;
+static int qhimark = 10000;
+module_param(blimit, int, 0644);
+module_param(qhimark, int, 0644);
+
 /* Forward declarations for rcutiny_plugin.h. */
 struct rcu_ctrlblk;
 static void rcu_process_callbacks(struct rcu_ctrlblk *rcp);
@@ -138,13 +148,16 @@ void rcu_check_callbacks(int cpu, int user)
 
 /*
  * Invoke the RCU callbacks on the specified rcu_ctrlkblk structure
- * whose grace period has elapsed.
+ * whose grace period has elapsed.  Those beyond blimit are put back at
+ * the head of the list for the next pass of rcu_kthread().
  */
 static void rcu_process_callbacks(struct rcu_ctrlblk *rcp)
 {
 	struct rcu_head *next, *list;
+	struct rcu_head **tail;
 	unsigned long flags;
-	RCU_TRACE(int cb_count = 0);
+	long count = 0;
+	long limit;
 
 	/* If no RCU callbacks ready to invoke, just return. */
 	if (&rcp->rcucblist == rcp->donetail)
@@ -153,16 +166,18 @@ static void rcu_process_callbacks(struct rcu_ctrlblk *rcp)
 	/* Move the ready-to-invoke callbacks to a local list. */
 	local_irq_save(flags);
 	list = rcp->rcucblist;
-	rcp->rcucblist = *rcp->donetail;
-	*rcp->donetail = NULL;
-	if (rcp->curtail == rcp->donetail)
+	tail = rcp->donetail;
+	rcp->rcucblist = *tail;
+	*tail = NULL;
+	if (rcp->curtail == tail)
 		rcp->curtail = &rcp->rcucblist;
 	rcu_preempt_remove_callbacks(rcp);
 	rcp->donetail = &rcp->rcucblist;
+	limit = rcp->qlen > qhimark ? LONG_MAX : max(blimit, 1);
 	local_irq_restore(flags);
 
 	/* Invoke the callbacks on the local list. */
-	while (list) {
+	while (list && count < limit) {
 		next = list->next;
 		prefetch(next);
 		debug_rcu_head_unqueue(list);
@@ -170,9 +185,29 @@ static void rcu_process_callbacks(struct rcu_ctrlblk *rcp)
 		list->func(list);
 		local_bh_enable();
 		list = next;
-		RCU_TRACE(cb_count++);
+		count++;
 	}
-	RCU_TRACE(rcu_trace_sub_qlen(rcp, cb_count));
+
+	local_irq_save(flags);
+	RCU_TRACE(rcu_trace_batch(rcp, count, list != NULL));
+	rcp->qlen -= count;
+	if (list) {
+		/*
+		 * Still done, so they go ahead of anything queued meanwhile,
+		 * and any tail left pointing at the empty list follows them.
+		 */
+		*tail = rcp->rcucblist;
+		rcp->rcucblist = list;
+		if (rcp->donetail == &rcp->rcucblist)
+			rcp->donetail = tail;
+		if (rcp->curtail == &rcp->rcucblist)
+			rcp->curtail = tail;
+		rcu_preempt_requeue_callbacks(rcp, tail);
+	}
+	local_irq_restore(flags);
+
+	if (list)
+		invoke_rcu_kthread();
 }
 
 /*
@@ -256,7 +291,7 @@ static void __call_rcu(struct rcu_head *head,
 	local_irq_save(flags);
 	*rcp->curtail = head;
 	rcp->curtail = &head->next;
-	RCU_TRACE(rcp->qlen++);
+	rcp->qlen++;
 	local_irq_restore(flags);
 }
 
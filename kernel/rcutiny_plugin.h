@@ -37,7 +37,11 @@ struct rcu_ctrlblk {
 	struct rcu_head *rcucblist;	/* List of pending callbacks (CBs). */
 	struct rcu_head **donetail;	/* ->next pointer of last "done" CB. */
 	struct rcu_head **curtail;	/* ->next pointer of last CB. */
-	RCU_TRACE(long qlen);		/* Number of pending CBs. */
+	long qlen;			/* Number of pending CBs. */
+	RCU_TRACE(long max_qlen);	/* Most CBs pending at invocation. */
+	RCU_TRACE(long max_batch);	/* Most CBs invoked in one pass. */
+	RCU_TRACE(unsigned long n_deferred);
+					/* Passes cut short by blimit. */
 };
 
 /* Definition for rcupdate control block. */
@@ -209,8 +213,12 @@ static void rcu_initiate_exp_boost_trace(void);
  */
 static void show_tiny_preempt_stats(struct seq_file *m)
 {
-	seq_printf(m, "rcu_preempt: qlen=%ld gp=%lu g%u/p%u/c%u tasks=%c%c%c\n",
+	seq_printf(m, "rcu_preempt: qlen=%ld mq=%ld mb=%ld dfr=%lu "
+		   "gp=%lu g%u/p%u/c%u tasks=%c%c%c\n",
 		   rcu_preempt_ctrlblk.rcb.qlen,
+		   rcu_preempt_ctrlblk.rcb.max_qlen,
+		   rcu_preempt_ctrlblk.rcb.max_batch,
+		   rcu_preempt_ctrlblk.rcb.n_deferred,
 		   rcu_preempt_ctrlblk.n_grace_periods,
 		   rcu_preempt_ctrlblk.gpnum,
 		   rcu_preempt_ctrlblk.gpcpu,
@@ -678,6 +686,18 @@ static void rcu_preempt_remove_callbacks(struct rcu_ctrlblk *rcp)
 		rcu_preempt_ctrlblk.nexttail = &rcp->rcucblist;
 }
 
+/*
+ * Likewise for rcu_process_callbacks() putting back the ready callbacks
+ * it did not get to: if ->nexttail was left pointing at the empty list,
+ * it must now point to the ->next pointer of the last of them.
+ */
+static void rcu_preempt_requeue_callbacks(struct rcu_ctrlblk *rcp,
+					  struct rcu_head **tail)
+{
+	if (rcu_preempt_ctrlblk.nexttail == &rcp->rcucblist)
+		rcu_preempt_ctrlblk.nexttail = tail;
+}
+
 /*
  * Process callbacks for preemptible RCU.
  */
@@ -700,7 +720,7 @@ void call_rcu(struct rcu_head *head, void (*func)(struct rcu_head *rcu))
 	local_irq_save(flags);
 	*rcu_preempt_ctrlblk.nexttail = head;
 	rcu_preempt_ctrlblk.nexttail = &head->next;
-	RCU_TRACE(rcu_preempt_ctrlblk.rcb.qlen++);
+	rcu_preempt_ctrlblk.rcb.qlen++;
 	rcu_preempt_start_gp();  /* checks to see if GP needed. */
 	local_irq_restore(flags);
 }
@@ -720,6 +740,14 @@ void rcu_barrier(void)
 }
 EXPORT_SYMBOL_GPL(rcu_barrier);
 
+/*
+ * Wait for the readers blocked at the time of the call rather than for a
+ * callback queued behind all the others, which rcu_kthread() may take
+ * several passes to get through.
+ */
+static int expedited = 1;
+module_param(expedited, int, 0644);
+
 /*
  * synchronize_rcu - wait until a grace period has elapsed.
  *
@@ -740,6 +768,15 @@ void synchronize_rcu(void)
 	if (!rcu_preempt_blocked_readers_any())
 		return;
 
+	/*
+	 * On a single CPU, the only readers a grace period has to wait for
+	 * are the blocked ones, which is just what the expedited path does.
+	 */
+	if (expedited) {
+		synchronize_rcu_expedited();
+		return;
+	}
+
 	/* Once we get past the fastpath checks, same code as rcu_barrier(). */
 	rcu_barrier();
 }
@@ -894,6 +931,15 @@ static void rcu_preempt_remove_callbacks(struct rcu_ctrlblk *rcp)
 {
 }
 
+/*
+ * Because preemptible RCU does not exist, it never has any callbacks
+ * to requeue.
+ */
+static void rcu_preempt_requeue_callbacks(struct rcu_ctrlblk *rcp,
+					  struct rcu_head **tail)
+{
+}
+
 /*
  * Because preemptible RCU does not exist, it never has any callbacks
  * to process.
@@ -953,13 +999,19 @@ static void rcu_initiate_exp_boost_trace(void)
 
 #endif /* #ifdef CONFIG_RCU_BOOST */
 
-static void rcu_trace_sub_qlen(struct rcu_ctrlblk *rcp, int n)
+/*
+ * Record the size of a burst of callbacks: how many were pending, and
+ * how many rcu_kthread() invoked in one pass.  Called with irqs disabled,
+ * before ->qlen is updated.
+ */
+static void rcu_trace_batch(struct rcu_ctrlblk *rcp, long count, int deferred)
 {
-	unsigned long flags;
-
-	raw_local_irq_save(flags);
-	rcp->qlen -= n;
-	raw_local_irq_restore(flags);
+	if (rcp->qlen > rcp->max_qlen)
+		rcp->max_qlen = rcp->qlen;
+	if (count > rcp->max_batch)
+		rcp->max_batch = count;
+	if (deferred)
+		rcp->n_deferred++;
 }
 
 /*
@@ -968,8 +1020,12 @@ static void rcu_trace_sub_qlen(struct rcu_ctrlblk *rcp, int n)
 static int show_tiny_stats(struct seq_file *m, void *unused)
 {
 	show_tiny_preempt_stats(m);
-	seq_printf(m, "rcu_sched: qlen: %ld\n", rcu_sched_ctrlblk.qlen);
-	seq_printf(m, "rcu_bh: qlen: %ld\n", rcu_bh_ctrlblk.qlen);
+	seq_printf(m, "rcu_sched: qlen: %ld mq: %ld mb: %ld dfr: %lu\n",
+		   rcu_sched_ctrlblk.qlen, rcu_sched_ctrlblk.max_qlen,
+		   rcu_sched_ctrlblk.max_batch, rcu_sched_ctrlblk.n_deferred);
+	seq_printf(m, "rcu_bh: qlen: %ld mq: %ld mb: %ld dfr: %lu\n",
+		   rcu_bh_ctrlblk.qlen, rcu_bh_ctrlblk.max_qlen,
+		   rcu_bh_ctrlblk.max_batch, rcu_bh_ctrlblk.n_deferred);
 	return 0;
 }
 
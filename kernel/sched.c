@@ -305,6 +305,25 @@ struct task_group root_task_group;
 
 #endif	/* CONFIG_CGROUP_SCHED */
 
+#ifdef CONFIG_SCHED_MM_SWITCH_COST
+/* What a context switch costs, as far as the caches are concerned */
+enum {
+	MM_SWITCH_NONE,		/* same mm, or a kernel thread */
+	MM_SWITCH_CHEAP,	/* to another mm, the caches are kept */
+	MM_SWITCH_FLUSH,	/* to another mm, the caches are flushed */
+	MM_SWITCH_NR_COSTS
+};
+
+static inline int mm_switch_cost(struct mm_struct *prev,
+				 struct task_struct *next)
+{
+	if (!next->mm || next->mm == prev)
+		return MM_SWITCH_NONE;
+	return arch_mm_switch_flushes(prev, next->mm) ?
+		MM_SWITCH_FLUSH : MM_SWITCH_CHEAP;
+}
+#endif
+
 /* CFS-related fields in a runqueue */
 struct cfs_rq {
 	struct load_weight load;
@@ -327,6 +346,11 @@ struct cfs_rq {
 
 	unsigned int nr_spread_over;
 
+#ifdef CONFIG_SCHEDSTATS
+	/* of the tasks in this group and below, see sched_statistics */
+	unsigned int wakeup_lat_hist[SCHED_LAT_BUCKETS];
+#endif
+
 #ifdef CONFIG_FAIR_GROUP_SCHED
 	struct rq *rq;	/* cpu runqueue to which this cfs_rq is attached */
 
@@ -466,6 +490,11 @@ struct rq {
 	struct load_weight load;
 	unsigned long nr_load_updates;
 	u64 nr_switches;
+#ifdef CONFIG_SCHED_MM_SWITCH_COST
+	/* context switches by cost, and picks changed to save a flush */
+	unsigned long nr_mm_switches[MM_SWITCH_NR_COSTS];
+	unsigned long nr_mm_switch_picks;
+#endif
 
 	struct cfs_rq cfs;
 	struct rt_rq rt;
@@ -2960,6 +2989,9 @@ context_switch(struct rq *rq, struct task_struct *prev,
 
 	mm = next->mm;
 	oldmm = prev->active_mm;
+#ifdef CONFIG_SCHED_MM_SWITCH_COST
+	rq->nr_mm_switches[mm_switch_cost(oldmm, next)]++;
+#endif
 	/*
 	 * For paravirt, this is coupled with an exit in switch_to to
 	 * combine the page table reload and the switch backend into
@@ -9139,6 +9171,28 @@ static u64 cpu_shares_read_u64(struct cgroup *cgrp, struct cftype *cft)
 
 	return (u64) tg->shares;
 }
+
+#ifdef CONFIG_SCHEDSTATS
+static int cpu_wakeup_latency_read(struct cgroup *cgrp, struct cftype *cft,
+				   struct seq_file *m)
+{
+	struct task_group *tg = cgroup_tg(cgrp);
+	unsigned long hist[SCHED_LAT_BUCKETS];
+	int cpu, i;
+
+	memset(hist, 0, sizeof(hist));
+	for_each_possible_cpu(cpu) {
+		for (i = 0; i < SCHED_LAT_BUCKETS; i++)
+			hist[i] += tg->cfs_rq[cpu]->wakeup_lat_hist[i];
+	}
+
+	for (i = 0; i < SCHED_LAT_BUCKETS; i++)
+		seq_printf(m, i ? " %lu" : "%lu", hist[i]);
+	seq_putc(m, '\n');
+
+	return 0;
+}
+#endif
 #endif /* CONFIG_FAIR_GROUP_SCHED */
 
 #ifdef CONFIG_RT_GROUP_SCHED
@@ -9172,6 +9226,12 @@ static struct cftype cpu_files[] = {
 		.read_u64 = cpu_shares_read_u64,
 		.write_u64 = cpu_shares_write_u64,
 	},
+#ifdef CONFIG_SCHEDSTATS
+	{
+		.name = "wakeup_latency",
+		.read_seq_string = cpu_wakeup_latency_read,
+	},
+#endif
 #endif
 #ifdef CONFIG_RT_GROUP_SCHED
 	{
@@ -277,6 +277,12 @@ static void print_cpu(struct seq_file *m, int cpu)
 	P(cpu_load[2]);
 	P(cpu_load[3]);
 	P(cpu_load[4]);
+#ifdef CONFIG_SCHED_MM_SWITCH_COST
+	P(nr_mm_switches[0]);
+	P(nr_mm_switches[1]);
+	P(nr_mm_switches[2]);
+	P(nr_mm_switch_picks);
+#endif
 #undef P
 #undef PN
 
@@ -82,6 +82,19 @@ unsigned int normalized_sysctl_sched_wakeup_granularity = 1000000UL;
 
 const_debug unsigned int sysctl_sched_migration_cost = 500000UL;
 
+#ifdef CONFIG_SCHED_MM_SWITCH_COST
+/*
+ * How far, in virtual runtime, a task may be behind the next task in
+ * line and still be picked because switching to it doesn't flush the
+ * caches.
+ * (default: 2 msec, units: nanoseconds)
+ */
+unsigned int sysctl_sched_mm_switch_tolerance = 2000000UL;
+
+/* At most that many tasks are looked at */
+#define SCHED_MM_SWITCH_SCAN	4
+#endif
+
 /*
  * The exponential sliding  window over which load is averaged for shares
  * distribution.
@@ -606,6 +619,42 @@ update_stats_wait_start(struct cfs_rq *cfs_rq, struct sched_entity *se)
 	schedstat_set(se->statistics.wait_start, rq_of(cfs_rq)->clock);
 }
 
+/*
+ * Wakeup to run latency of tasks: from enqueue_task_fair() with
+ * ENQUEUE_WAKEUP to pick_next_task_fair().
+ */
+static inline void
+update_stats_wakeup_start(struct cfs_rq *cfs_rq, struct sched_entity *se)
+{
+	schedstat_set(se->statistics.wakeup_start, rq_of(cfs_rq)->clock);
+}
+
+#ifdef CONFIG_SCHEDSTATS
+static void update_stats_wakeup_end(struct cfs_rq *cfs_rq,
+				    struct sched_entity *se)
+{
+	s64 delta = rq_of(cfs_rq)->clock - se->statistics.wakeup_start;
+	int bucket = 0;
+
+	if (!se->statistics.wakeup_start)
+		return;
+	se->statistics.wakeup_start = 0;
+
+	if (delta > 0)
+		bucket = min(fls64(delta >> 10), SCHED_LAT_BUCKETS - 1);
+	se->statistics.wakeup_lat_hist[bucket]++;
+
+	/* Account it to the task's group and the groups above it */
+	for_each_sched_entity(se)
+		cfs_rq_of(se)->wakeup_lat_hist[bucket]++;
+}
+#else
+static inline void update_stats_wakeup_end(struct cfs_rq *cfs_rq,
+					   struct sched_entity *se)
+{
+}
+#endif
+
 /*
  * Task is being enqueued - update stats:
  */
@@ -1160,6 +1209,41 @@ set_next_entity(struct cfs_rq *cfs_rq, struct sched_entity *se)
 static int
 wakeup_preempt_entity(struct sched_entity *curr, struct sched_entity *se);
 
+#ifdef CONFIG_SCHED_MM_SWITCH_COST
+/*
+ * If switching to @se flushes the caches, look for a task close behind
+ * @left which can be switched to without.
+ */
+static struct sched_entity *
+pick_cheap_mm_switch(struct cfs_rq *cfs_rq, struct sched_entity *se,
+		     struct sched_entity *left)
+{
+	struct rq *rq = rq_of(cfs_rq);
+	struct mm_struct *mm = rq->curr->active_mm;
+	struct sched_entity *cand;
+	int nr = 0;
+
+	if (!entity_is_task(se) ||
+	    mm_switch_cost(mm, task_of(se)) != MM_SWITCH_FLUSH)
+		return se;
+
+	for (cand = left; cand && nr < SCHED_MM_SWITCH_SCAN;
+	     cand = __pick_next_entity(cand), nr++) {
+		if ((s64)(cand->vruntime - left->vruntime) >
+		    (s64)sysctl_sched_mm_switch_tolerance)
+			break;
+		if (cand == se || cand == cfs_rq->skip || !entity_is_task(cand))
+			continue;
+		if (mm_switch_cost(mm, task_of(cand)) != MM_SWITCH_FLUSH) {
+			rq->nr_mm_switch_picks++;
+			return cand;
+		}
+	}
+
+	return se;
+}
+#endif
+
 /*
  * Pick the next process, keeping these things in mind, in this order:
  * 1) keep things fair between processes/task groups
@@ -1182,6 +1266,14 @@ static struct sched_entity *pick_next_entity(struct cfs_rq *cfs_rq)
 			se = second;
 	}
 
+#ifdef CONFIG_SCHED_MM_SWITCH_COST
+	/*
+	 * Avoid flushing the caches, if it can be done without getting
+	 * too unfair.
+	 */
+	se = pick_cheap_mm_switch(cfs_rq, se, left);
+#endif
+
 	/*
 	 * Prefer last buddy, try to return the CPU to a preempted task.
 	 */
@@ -1322,6 +1414,9 @@ enqueue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 	struct cfs_rq *cfs_rq;
 	struct sched_entity *se = &p->se;
 
+	if (flags & ENQUEUE_WAKEUP)
+		update_stats_wakeup_start(cfs_rq_of(se), se);
+
 	for_each_sched_entity(se) {
 		if (se->on_rq)
 			break;
@@ -1929,6 +2024,7 @@ static struct task_struct *pick_next_task_fair(struct rq *rq)
 	} while (cfs_rq);
 
 	p = task_of(se);
+	update_stats_wakeup_end(cfs_rq_of(se), se);
 	hrtick_start_fair(rq, p);
 
 	return p;
@@ -4141,6 +4237,9 @@ static void switched_from_fair(struct rq *rq, struct task_struct *p)
 	struct sched_entity *se = &p->se;
 	struct cfs_rq *cfs_rq = cfs_rq_of(se);
 
+	/* Its wakeup latency is no longer ours to account */
+	schedstat_set(se->statistics.wakeup_start, 0);
+
 	/*
 	 * Ensure the task's vruntime is normalized, so that when its
 	 * switched back to the fair class the enqueue_entity(.flags=0) will
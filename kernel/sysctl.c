@@ -56,6 +56,7 @@
 #include <linux/kprobes.h>
 #include <linux/pipe_fs_i.h>
 #include <linux/oom.h>
+#include <linux/mem_notify.h>
 
 #include <asm/uaccess.h>
 #include <asm/processor.h>
@@ -265,6 +266,11 @@ static int min_sched_tunable_scaling = SCHED_TUNABLESCALING_NONE;
 static int max_sched_tunable_scaling = SCHED_TUNABLESCALING_END-1;
 #endif
 
+#ifdef CONFIG_SCHED_MM_SWITCH_COST
+static int min_mm_switch_tolerance_ns;			/* 0 usecs */
+static int max_mm_switch_tolerance_ns = NSEC_PER_SEC;	/* 1 second */
+#endif
+
 #ifdef CONFIG_COMPACTION
 static int min_extfrag_threshold;
 static int max_extfrag_threshold = 1000;
@@ -278,6 +284,17 @@ static struct ctl_table kern_table[] = {
 		.mode		= 0644,
 		.proc_handler	= proc_dointvec,
 	},
+#ifdef CONFIG_SCHED_MM_SWITCH_COST
+	{
+		.procname	= "sched_mm_switch_tolerance_ns",
+		.data		= &sysctl_sched_mm_switch_tolerance,
+		.maxlen		= sizeof(unsigned int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &min_mm_switch_tolerance_ns,
+		.extra2		= &max_mm_switch_tolerance_ns,
+	},
+#endif
 #ifdef CONFIG_SCHED_DEBUG
 	{
 		.procname	= "sched_min_granularity_ns",
@@ -1019,6 +1036,34 @@ static struct ctl_table vm_table[] = {
 		.proc_handler	= proc_dointvec_minmax,
 		.extra1		= &zero,
 	},
+	{
+		.procname	= "swap_locality",
+		.data		= &swap_locality,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &zero,
+	},
+#ifdef CONFIG_MEM_NOTIFY
+	{
+		.procname	= "mem_notify_medium",
+		.data		= &sysctl_mem_notify_medium,
+		.maxlen		= sizeof(sysctl_mem_notify_medium),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &zero,
+		.extra2		= &one_hundred,
+	},
+	{
+		.procname	= "mem_notify_critical",
+		.data		= &sysctl_mem_notify_critical,
+		.maxlen		= sizeof(sysctl_mem_notify_critical),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &zero,
+		.extra2		= &one_hundred,
+	},
+#endif
 	{
 		.procname	= "dirty_background_ratio",
 		.data		= &dirty_background_ratio,
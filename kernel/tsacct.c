@@ -22,6 +22,8 @@
 #include <linux/acct.h>
 #include <linux/jiffies.h>
 #include <linux/mm.h>
+#include <linux/proc_fs.h>
+#include <linux/ptrace.h>
 
 /*
  * fill in basic accounting fields
@@ -90,9 +92,23 @@ void xacct_add_tsk(struct taskstats *stats, struct task_struct *p)
 	stats->virtmem = p->acct_vm_mem1 * PAGE_SIZE / MB;
 	mm = get_task_mm(p);
 	if (mm) {
+		unsigned long rss, pss, uss;
+
 		/* adjust to KB unit */
 		stats->hiwater_rss   = get_mm_hiwater_rss(mm) * PAGE_SIZE / KB;
 		stats->hiwater_vm    = get_mm_hiwater_vm(mm)  * PAGE_SIZE / KB;
+		/*
+		 * That takes a page table walk under mmap_sem: fine for a
+		 * query, not for every exit, which may come from an oops
+		 * with mmap_sem held. Anyone may query any task, so only
+		 * those allowed to read its /proc/<pid>/pss get it here.
+		 */
+		if (!(p->flags & PF_EXITING) &&
+		    ptrace_may_access(p, PTRACE_MODE_READ)) {
+			task_pss(mm, &rss, &pss, &uss);
+			stats->pss   = pss;
+			stats->uss   = uss;
+		}
 		mmput(mm);
 	}
 	stats->read_char	= p->ioac.rchar;
@@ -30,6 +30,9 @@
 int watchdog_enabled = 1;
 int __read_mostly softlockup_thresh = 60;
 
+/* The sample period only needs to be well under softlockup_thresh */
+static DEFINE_HRTIMER_CLASS(watchdog_timer_class, NSEC_PER_SEC / 2);
+
 static DEFINE_PER_CPU(unsigned long, watchdog_touch_ts);
 static DEFINE_PER_CPU(struct task_struct *, softlockup_watchdog);
 static DEFINE_PER_CPU(struct hrtimer, watchdog_hrtimer);
@@ -319,8 +322,8 @@ static int watchdog(void *unused)
 
 	/* kick off the timer for the hardlockup detector */
 	/* done here because hrtimer_start can only pin to smp_processor_id() */
-	hrtimer_start(hrtimer, ns_to_ktime(get_sample_period()),
-		      HRTIMER_MODE_REL_PINNED);
+	hrtimer_start_class(hrtimer, ns_to_ktime(get_sample_period()),
+			    &watchdog_timer_class, HRTIMER_MODE_REL_PINNED);
 
 	set_current_state(TASK_INTERRUPTIBLE);
 	/*
@@ -575,6 +578,8 @@ void __init lockup_detector_init(void)
 	void *cpu = (void *)(long)smp_processor_id();
 	int err;
 
+	hrtimer_class_register(&watchdog_timer_class);
+
 	err = cpu_callback(&cpu_nfb, CPU_UP_PREPARE, cpu);
 	WARN_ON(notifier_to_errno(err));
 
@@ -41,6 +41,8 @@
 #include <linux/debug_locks.h>
 #include <linux/lockdep.h>
 #include <linux/idr.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include "workqueue_sched.h"
 
@@ -216,6 +218,19 @@ typedef unsigned long mayday_mask_t;
 #define free_mayday_mask(mask)			do { } while (0)
 #endif
 
+#ifdef CONFIG_WORKQUEUE_STATS
+/*
+ * Bucket 0 counts the works which took less than 1us, bucket n those
+ * which took [2^(n-1), 2^n) usecs; the last one everything longer.
+ */
+#define WQ_STAT_BUCKETS		20
+
+struct wq_stats {
+	unsigned long		queue[WQ_STAT_BUCKETS];	/* queue to start */
+	unsigned long		exec[WQ_STAT_BUCKETS];	/* execution */
+};
+#endif
+
 /*
  * The externally visible workqueue abstraction is an array of
  * per-CPU workqueues:
@@ -245,6 +260,9 @@ struct workqueue_struct {
 #ifdef CONFIG_LOCKDEP
 	struct lockdep_map	lockdep_map;
 #endif
+#ifdef CONFIG_WORKQUEUE_STATS
+	struct wq_stats __percpu *stats;	/* I: latency histograms */
+#endif
 };
 
 struct workqueue_struct *system_wq __read_mostly;
@@ -435,6 +453,72 @@ static DEFINE_SPINLOCK(workqueue_lock);
 static LIST_HEAD(workqueues);
 static bool workqueue_freezing;		/* W: have wqs started freezing? */
 
+#ifdef CONFIG_WORKQUEUE_STATS
+/* The work functions with the longest execution times seen */
+#define WQ_STAT_TOP		16
+
+struct wq_stat_top {
+	work_func_t		func;
+	u32			max_us;
+};
+
+static DEFINE_SPINLOCK(wq_stat_top_lock);
+static struct wq_stat_top wq_stat_top[WQ_STAT_TOP];
+static u32 wq_stat_top_min;	/* smallest max_us in wq_stat_top */
+
+static inline u32 wq_stat_clock(void)
+{
+	return local_clock() >> 10;
+}
+
+static inline int wq_stat_bucket(u32 us)
+{
+	return min(fls(us), WQ_STAT_BUCKETS - 1);
+}
+
+static void wq_stat_top_update(work_func_t func, u32 us)
+{
+	unsigned long flags;
+	int i, min = 0;
+
+	spin_lock_irqsave(&wq_stat_top_lock, flags);
+	for (i = 0; i < WQ_STAT_TOP; i++) {
+		if (wq_stat_top[i].func == func) {
+			wq_stat_top[i].max_us = max(wq_stat_top[i].max_us, us);
+			goto out;
+		}
+		if (wq_stat_top[i].max_us < wq_stat_top[min].max_us)
+			min = i;
+	}
+	wq_stat_top[min].func = func;
+	wq_stat_top[min].max_us = us;
+out:
+	wq_stat_top_min = wq_stat_top[0].max_us;
+	for (i = 1; i < WQ_STAT_TOP; i++)
+		wq_stat_top_min = min(wq_stat_top_min, wq_stat_top[i].max_us);
+	spin_unlock_irqrestore(&wq_stat_top_lock, flags);
+}
+
+static inline void wq_stat_queued(struct work_struct *work)
+{
+	work->queued_at = wq_stat_clock();
+}
+
+/* @work has been dequeued at @start, it may be gone by now */
+static void wq_stat_executed(struct workqueue_struct *wq, work_func_t func,
+			     u32 queued_at, u32 start)
+{
+	u32 end = wq_stat_clock();
+
+	this_cpu_inc(wq->stats->queue[wq_stat_bucket(start - queued_at)]);
+	this_cpu_inc(wq->stats->exec[wq_stat_bucket(end - start)]);
+
+	/* Racy, the lock is only taken for the slowest works */
+	if (unlikely(end - start > ACCESS_ONCE(wq_stat_top_min)))
+		wq_stat_top_update(func, end - start);
+}
+#endif
+
 /*
  * The almighty global cpu workqueues.  nr_running is the only field
  * which is expected to be used frequently by other cpus via
@@ -926,6 +1010,9 @@ static void insert_work(struct cpu_workqueue_struct *cwq,
 
 	/* we own @work, set data and link */
 	set_work_cwq(work, cwq, extra_flags);
+#ifdef CONFIG_WORKQUEUE_STATS
+	wq_stat_queued(work);
+#endif
 
 	/*
 	 * Ensure that we get the right work->data if we see the
@@ -1804,6 +1891,9 @@ __acquires(&gcwq->lock)
 	work_func_t f = work->func;
 	int work_color;
 	struct worker *collision;
+#ifdef CONFIG_WORKQUEUE_STATS
+	u32 queued_at = work->queued_at, start;
+#endif
 #ifdef CONFIG_LOCKDEP
 	/*
 	 * It is permissible to free the struct work_struct from
@@ -1865,12 +1955,18 @@ __acquires(&gcwq->lock)
 	lock_map_acquire_read(&cwq->wq->lockdep_map);
 	lock_map_acquire(&lockdep_map);
 	trace_workqueue_execute_start(work);
+#ifdef CONFIG_WORKQUEUE_STATS
+	start = wq_stat_clock();
+#endif
 	f(work);
 	/*
 	 * While we must be careful to not use "work" after this, the trace
 	 * point will only record its address.
 	 */
 	trace_workqueue_execute_end(work);
+#ifdef CONFIG_WORKQUEUE_STATS
+	wq_stat_executed(cwq->wq, f, queued_at, start);
+#endif
 	lock_map_release(&lockdep_map);
 	lock_map_release(&cwq->wq->lockdep_map);
 
@@ -2946,6 +3042,12 @@ struct workqueue_struct *__alloc_workqueue_key(const char *name,
 	if (alloc_cwqs(wq) < 0)
 		goto err;
 
+#ifdef CONFIG_WORKQUEUE_STATS
+	wq->stats = alloc_percpu(struct wq_stats);
+	if (!wq->stats)
+		goto err;
+#endif
+
 	for_each_cwq_cpu(cpu, wq) {
 		struct cpu_workqueue_struct *cwq = get_cwq(cpu, wq);
 		struct global_cwq *gcwq = get_gcwq(cpu);
@@ -2994,6 +3096,9 @@ struct workqueue_struct *__alloc_workqueue_key(const char *name,
 	return wq;
 err:
 	if (wq) {
+#ifdef CONFIG_WORKQUEUE_STATS
+		free_percpu(wq->stats);
+#endif
 		free_cwqs(wq);
 		free_mayday_mask(wq->mayday_mask);
 		kfree(wq->rescuer);
@@ -3065,6 +3170,9 @@ reflush:
 		kfree(wq->rescuer);
 	}
 
+#ifdef CONFIG_WORKQUEUE_STATS
+	free_percpu(wq->stats);
+#endif
 	free_cwqs(wq);
 	kfree(wq);
 }
@@ -3798,3 +3906,110 @@ static int __init init_workqueues(void)
 	return 0;
 }
 early_initcall(init_workqueues);
+
+#ifdef CONFIG_WORKQUEUE_STATS
+/*
+ * debugfs "workqueue/latency": two lines per workqueue, the histograms
+ * of the queue to start latency and of the execution time.
+ */
+static int wq_stat_latency_show(struct seq_file *m, void *v)
+{
+	struct workqueue_struct *wq;
+	unsigned int cpu;
+	int i;
+
+	seq_puts(m, "# usecs: 0");
+	for (i = 1; i < WQ_STAT_BUCKETS; i++)
+		seq_printf(m, " %u", 1U << (i - 1));
+	seq_putc(m, '\n');
+
+	spin_lock(&workqueue_lock);
+	list_for_each_entry(wq, &workqueues, list) {
+		struct wq_stats sum;
+
+		memset(&sum, 0, sizeof(sum));
+		for_each_possible_cpu(cpu) {
+			struct wq_stats *stats = per_cpu_ptr(wq->stats, cpu);
+
+			for (i = 0; i < WQ_STAT_BUCKETS; i++) {
+				sum.queue[i] += stats->queue[i];
+				sum.exec[i] += stats->exec[i];
+			}
+		}
+
+		seq_printf(m, "%s queue", wq->name);
+		for (i = 0; i < WQ_STAT_BUCKETS; i++)
+			seq_printf(m, " %lu", sum.queue[i]);
+		seq_printf(m, "\n%s exec", wq->name);
+		for (i = 0; i < WQ_STAT_BUCKETS; i++)
+			seq_printf(m, " %lu", sum.exec[i]);
+		seq_putc(m, '\n');
+	}
+	spin_unlock(&workqueue_lock);
+
+	return 0;
+}
+
+/* debugfs "workqueue/slowest": the slowest work functions, slowest first */
+static int wq_stat_slowest_show(struct seq_file *m, void *v)
+{
+	struct wq_stat_top top[WQ_STAT_TOP];
+	int i, j;
+
+	spin_lock_irq(&wq_stat_top_lock);
+	memcpy(top, wq_stat_top, sizeof(top));
+	spin_unlock_irq(&wq_stat_top_lock);
+
+	/* Selection sort, WQ_STAT_TOP is small */
+	for (i = 0; i < WQ_STAT_TOP; i++) {
+		for (j = i + 1; j < WQ_STAT_TOP; j++)
+			if (top[j].max_us > top[i].max_us)
+				swap(top[i], top[j]);
+		if (!top[i].func)
+			break;
+		seq_printf(m, "%u %pf\n", top[i].max_us, top[i].func);
+	}
+
+	return 0;
+}
+
+static int wq_stat_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, wq_stat_latency_show, NULL);
+}
+
+static int wq_stat_slowest_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, wq_stat_slowest_show, NULL);
+}
+
+static const struct file_operations wq_stat_latency_fops = {
+	.open		= wq_stat_latency_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static const struct file_operations wq_stat_slowest_fops = {
+	.open		= wq_stat_slowest_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init wq_stat_debugfs_init(void)
+{
+	struct dentry *dir;
+
+	dir = debugfs_create_dir("workqueue", NULL);
+	if (!dir)
+		return -ENOMEM;
+
+	debugfs_create_file("latency", S_IRUGO, dir, NULL,
+			    &wq_stat_latency_fops);
+	debugfs_create_file("slowest", S_IRUGO, dir, NULL,
+			    &wq_stat_slowest_fops);
+	return 0;
+}
+late_initcall(wq_stat_debugfs_init);
+#endif /* CONFIG_WORKQUEUE_STATS */
@@ -0,0 +1,381 @@
+/*
+ * linux/mm/boot_prefetch.c
+ *
+ * Boot time page cache prefetching.
+ *
+ * With "prefetch_trace=<file>" on the command line, a boot which finds no
+ * <file> records which file pages readahead reads from disk during the
+ * first seconds after the root filesystem is mounted, and saves them to
+ * <file>. Later boots read the trace back and, from a kernel thread running
+ * alongside init, read the same pages ahead in disk block order: the many
+ * small random reads of a cold boot become a mostly sequential sweep, and
+ * init finds its binaries and libraries in the page cache.
+ */
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/boot_prefetch.h>
+#include <linux/fs.h>
+#include <linux/file.h>
+#include <linux/kthread.h>
+#include <linux/mm.h>
+#include <linux/pagemap.h>
+#include <linux/path.h>
+#include <linux/dcache.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+#include <linux/swap.h>
+#include <linux/vmalloc.h>
+#include <linux/workqueue.h>
+#include <asm/uaccess.h>
+
+#define PREFETCH_MAX_RECORDS	4096
+#define PREFETCH_MAX_TRACE	(1 << 20)	/* bytes of trace read back */
+#define PREFETCH_MERGE_DEPTH	8		/* records to try merging with */
+#define PREFETCH_SAVE_RETRIES	12
+#define PREFETCH_SAVE_DELAY	(5 * HZ)
+
+/* Not __initdata: the trace is saved long after init */
+static char prefetch_trace[256];
+static int prefetch_secs = 30;
+static bool prefetch_force_record;
+
+static int __init setup_prefetch_trace(char *str)
+{
+	strlcpy(prefetch_trace, str, sizeof(prefetch_trace));
+	return 1;
+}
+__setup("prefetch_trace=", setup_prefetch_trace);
+
+static int __init setup_prefetch_record(char *str)
+{
+	prefetch_force_record = true;
+	if (*str == '=')
+		prefetch_secs = simple_strtoul(str + 1, NULL, 0);
+	return 1;
+}
+__setup("prefetch_record", setup_prefetch_record);
+
+/*
+ * Recording
+ */
+
+/* Pages [start, start + nr_pages) of a file were read from disk */
+struct prefetch_rec {
+	struct path path;
+	pgoff_t start;
+	unsigned long nr_pages;
+};
+
+int boot_prefetch_recording;
+static DEFINE_SPINLOCK(prefetch_lock);
+static struct prefetch_rec *prefetch_recs;
+static unsigned int prefetch_nr_recs;
+static int prefetch_save_tries;
+
+void __boot_prefetch_record(struct file *file, pgoff_t start,
+			    unsigned long nr_pages)
+{
+	struct inode *inode = file->f_mapping->host;
+	struct prefetch_rec *rec;
+	unsigned int i;
+
+	/* Prefetching only pays off for regular files on disks */
+	if (!S_ISREG(inode->i_mode) || !inode->i_sb->s_bdev || !nr_pages)
+		return;
+
+	spin_lock(&prefetch_lock);
+	if (!boot_prefetch_recording)
+		goto out;
+
+	/* Sequential reads extend one of the last records */
+	for (i = prefetch_nr_recs;
+	     i && i + PREFETCH_MERGE_DEPTH > prefetch_nr_recs; i--) {
+		pgoff_t end;
+
+		rec = &prefetch_recs[i - 1];
+		if (rec->path.dentry->d_inode != inode ||
+		    start > rec->start + rec->nr_pages ||
+		    start + nr_pages < rec->start)
+			continue;
+
+		end = max(rec->start + rec->nr_pages, start + nr_pages);
+		rec->start = min(rec->start, start);
+		rec->nr_pages = end - rec->start;
+		goto out;
+	}
+
+	if (prefetch_nr_recs < PREFETCH_MAX_RECORDS) {
+		rec = &prefetch_recs[prefetch_nr_recs++];
+		rec->path = file->f_path;
+		path_get(&rec->path);
+		rec->start = start;
+		rec->nr_pages = nr_pages;
+	}
+out:
+	spin_unlock(&prefetch_lock);
+}
+
+static int prefetch_write(struct file *file, char *buf, size_t len)
+{
+	mm_segment_t old_fs;
+	ssize_t ret;
+
+	old_fs = get_fs();
+	set_fs(KERNEL_DS);
+	/* The cast to a user pointer is valid due to the set_fs() */
+	ret = vfs_write(file, (const char __user *)buf, len, &file->f_pos);
+	set_fs(old_fs);
+
+	if (ret < 0)
+		return ret;
+	return ret == len ? 0 : -EIO;
+}
+
+/* One "<start> <nr_pages> <path>" line per record */
+static int prefetch_save_trace(void)
+{
+	struct file *file;
+	char *buf, *pathbuf;
+	size_t len = 0;
+	unsigned int i;
+	int err = -ENOMEM;
+
+	file = filp_open(prefetch_trace, O_WRONLY | O_CREAT | O_TRUNC |
+			 O_LARGEFILE, 0600);
+	if (IS_ERR(file))
+		return PTR_ERR(file);
+
+	buf = (char *)__get_free_page(GFP_KERNEL);
+	pathbuf = kmalloc(PATH_MAX, GFP_KERNEL);
+	if (!buf || !pathbuf)
+		goto out;
+
+	err = 0;
+	for (i = 0; i < prefetch_nr_recs && !err; i++) {
+		struct prefetch_rec *rec = &prefetch_recs[i];
+		char *name;
+
+		if (d_unlinked(rec->path.dentry))
+			continue;
+		name = d_path(&rec->path, pathbuf, PATH_MAX);
+		if (IS_ERR(name) || strchr(name, '\n'))
+			continue;
+		/* Two numbers, two spaces and a newline */
+		if (strlen(name) + 2 * 21 + 3 > PAGE_SIZE)
+			continue;
+
+		if (len + strlen(name) + 2 * 21 + 3 > PAGE_SIZE) {
+			err = prefetch_write(file, buf, len);
+			len = 0;
+		}
+		len += snprintf(buf + len, PAGE_SIZE - len, "%lu %lu %s\n",
+				(unsigned long)rec->start, rec->nr_pages, name);
+	}
+	if (!err && len)
+		err = prefetch_write(file, buf, len);
+
+out:
+	kfree(pathbuf);
+	free_page((unsigned long)buf);
+	filp_close(file, NULL);
+
+	return err;
+}
+
+static void prefetch_save(struct work_struct *work);
+static DECLARE_DELAYED_WORK(prefetch_save_work, prefetch_save);
+
+static void prefetch_save(struct work_struct *work)
+{
+	unsigned int i;
+	int err;
+
+	spin_lock(&prefetch_lock);
+	boot_prefetch_recording = 0;
+	spin_unlock(&prefetch_lock);
+
+	/* The root filesystem may not be writable yet */
+	err = prefetch_save_trace();
+	if ((err == -EROFS || err == -ENOENT) &&
+	    ++prefetch_save_tries < PREFETCH_SAVE_RETRIES) {
+		schedule_delayed_work(&prefetch_save_work, PREFETCH_SAVE_DELAY);
+		return;
+	}
+
+	if (err)
+		printk(KERN_WARNING "prefetch: error %d saving %s\n",
+		       err, prefetch_trace);
+	else
+		printk(KERN_INFO "prefetch: saved %u ranges to %s\n",
+		       prefetch_nr_recs, prefetch_trace);
+
+	for (i = 0; i < prefetch_nr_recs; i++)
+		path_put(&prefetch_recs[i].path);
+	vfree(prefetch_recs);
+	prefetch_recs = NULL;
+}
+
+/*
+ * Replay
+ */
+
+struct prefetch_item {
+	struct file *file;
+	pgoff_t start;
+	unsigned long nr_pages;
+	dev_t dev;
+	sector_t block;		/* on dev, of the first page */
+};
+
+static int prefetch_cmp(const void *a, const void *b)
+{
+	const struct prefetch_item *l = a, *r = b;
+
+	if (l->dev != r->dev)
+		return l->dev < r->dev ? -1 : 1;
+	if (l->block != r->block)
+		return l->block < r->block ? -1 : 1;
+	return 0;
+}
+
+/* Parse the trace in @buf, opening the files it names */
+static unsigned int prefetch_parse(char *buf, char *end,
+				   struct prefetch_item *items,
+				   unsigned int max_items)
+{
+	struct file *prev_file = NULL;
+	char *line, *next, *prev_name = NULL;
+	unsigned int nr = 0;
+
+	for (line = buf; line < end && nr < max_items; line = next) {
+		struct prefetch_item *item = &items[nr];
+		struct inode *inode;
+		unsigned long start, nr_pages;
+		int n;
+
+		next = strchr(line, '\n');
+		if (!next)
+			break;
+		*next++ = '\0';
+
+		if (sscanf(line, "%lu %lu %n", &start, &nr_pages, &n) != 2 ||
+		    !line[n] || !nr_pages)
+			continue;
+
+		if (prev_file && !strcmp(line + n, prev_name)) {
+			get_file(prev_file);
+			item->file = prev_file;
+		} else {
+			item->file = filp_open(line + n, O_RDONLY | O_LARGEFILE, 0);
+			if (IS_ERR(item->file)) {
+				prev_file = NULL;
+				continue;
+			}
+			prev_file = item->file;
+			prev_name = line + n;
+		}
+
+		inode = item->file->f_mapping->host;
+		item->start = start;
+		item->nr_pages = nr_pages;
+		item->dev = inode->i_sb->s_dev;
+		item->block = bmap(inode, (sector_t)start <<
+				   (PAGE_CACHE_SHIFT - inode->i_blkbits));
+		nr++;
+	}
+
+	return nr;
+}
+
+static int prefetch_replay(void *data)
+{
+	struct file *trace = data;
+	struct prefetch_item *items = NULL;
+	unsigned long limit = totalram_pages / 4, done = 0;
+	unsigned long start_jiffies = jiffies;
+	unsigned int i, nr_lines = 0, nr_items = 0;
+	loff_t size;
+	char *buf, *p;
+	int len;
+
+	size = min_t(loff_t, i_size_read(trace->f_mapping->host),
+		     PREFETCH_MAX_TRACE);
+	buf = vmalloc(size + 1);
+	if (!buf)
+		goto out_close;
+
+	len = kernel_read(trace, 0, buf, size);
+	if (len <= 0)
+		goto out;
+	buf[len] = '\0';
+
+	for (p = buf; (p = strchr(p, '\n')); p++)
+		nr_lines++;
+	items = vmalloc(nr_lines * sizeof(*items));
+	if (!items)
+		goto out;
+
+	nr_items = prefetch_parse(buf, buf + len, items, nr_lines);
+	sort(items, nr_items, sizeof(*items), prefetch_cmp, NULL);
+
+	for (i = 0; i < nr_items; i++) {
+		struct prefetch_item *item = &items[i];
+
+		/* Don't push out what the system is already using */
+		if (done < limit) {
+			force_page_cache_readahead(item->file->f_mapping,
+						   item->file, item->start,
+						   item->nr_pages);
+			done += item->nr_pages;
+		}
+		fput(item->file);
+	}
+
+	printk(KERN_INFO "prefetch: read %lu pages of %u ranges in %u ms\n",
+	       done, nr_items, jiffies_to_msecs(jiffies - start_jiffies));
+out:
+	vfree(items);
+	vfree(buf);
+out_close:
+	filp_close(trace, NULL);
+	return 0;
+}
+
+/*
+ * Called once the root filesystem is mounted: replay the trace if there is
+ * one, record it otherwise.
+ */
+void __init boot_prefetch_start(void)
+{
+	struct task_struct *tsk;
+	struct file *trace;
+
+	if (!prefetch_trace[0])
+		return;
+
+	if (!prefetch_force_record) {
+		trace = filp_open(prefetch_trace, O_RDONLY | O_LARGEFILE, 0);
+		if (!IS_ERR(trace)) {
+			tsk = kthread_run(prefetch_replay, trace, "kprefetchd");
+			if (IS_ERR(tsk))
+				filp_close(trace, NULL);
+			return;
+		}
+		if (PTR_ERR(trace) != -ENOENT) {
+			printk(KERN_WARNING "prefetch: error %ld opening %s\n",
+			       PTR_ERR(trace), prefetch_trace);
+			return;
+		}
+	}
+
+	prefetch_recs = vmalloc(PREFETCH_MAX_RECORDS * sizeof(*prefetch_recs));
+	if (!prefetch_recs)
+		return;
+
+	boot_prefetch_recording = 1;
+	schedule_delayed_work(&prefetch_save_work, prefetch_secs * HZ);
+	printk(KERN_INFO "prefetch: recording for %d seconds\n", prefetch_secs);
+}
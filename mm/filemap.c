@@ -121,6 +121,7 @@ void __delete_from_page_cache(struct page *page)
 	radix_tree_delete(&mapping->page_tree, page->index);
 	page->mapping = NULL;
 	mapping->nrpages--;
+	readahead_evict(page);
 	__dec_zone_page_state(page, NR_FILE_PAGES);
 	if (PageSwapBacked(page))
 		__dec_zone_page_state(page, NR_SHMEM);
@@ -1082,6 +1083,7 @@ find_page:
 					ra, filp, page,
 					index, last_index - index);
 		}
+		readahead_hit(ra, page);
 		if (!PageUptodate(page)) {
 			if (inode->i_blkbits == PAGE_CACHE_SHIFT ||
 					!mapping->a_ops->is_partially_uptodate)
@@ -1628,6 +1630,7 @@ retry_find:
 		if (!page)
 			goto no_cached_page;
 	}
+	readahead_hit(ra, page);
 
 	if (!lock_page_or_retry(page, vma->vm_mm, vmf->flags)) {
 		page_cache_release(page);
@@ -188,6 +188,17 @@ static unsigned int ksm_thread_pages_to_scan = 100;
 /* Milliseconds ksmd should sleep between batches */
 static unsigned int ksm_thread_sleep_millisecs = 20;
 
+/*
+ * In adaptive mode, ksmd sleeps up to 1 << KSM_SLEEP_SHIFT_MAX times
+ * longer between batches while full scans find little new to merge.
+ */
+#define KSM_SLEEP_SHIFT_MAX	6
+static unsigned int ksm_thread_adaptive;
+static unsigned int ksm_sleep_shift;
+
+/* Pages shared and sharing when the current full scan started */
+static unsigned long ksm_scan_start_merged;
+
 #define KSM_RUN_STOP	0
 #define KSM_RUN_MERGE	1
 #define KSM_RUN_UNMERGE	2
@@ -452,6 +463,7 @@ static void remove_node_from_stable_tree(struct stable_node *stable_node)
 			ksm_pages_sharing--;
 		else
 			ksm_pages_shared--;
+		rmap_item->mm->ksm_merging_pages--;
 		put_anon_vma(rmap_item->anon_vma);
 		rmap_item->address &= PAGE_MASK;
 		cond_resched();
@@ -539,6 +551,7 @@ static void remove_rmap_item_from_tree(struct rmap_item *rmap_item)
 			ksm_pages_sharing--;
 		else
 			ksm_pages_shared--;
+		rmap_item->mm->ksm_merging_pages--;
 
 		put_anon_vma(rmap_item->anon_vma);
 		rmap_item->address &= PAGE_MASK;
@@ -1156,6 +1169,7 @@ static void stable_tree_append(struct rmap_item *rmap_item,
 		ksm_pages_sharing++;
 	else
 		ksm_pages_shared++;
+	rmap_item->mm->ksm_merging_pages++;
 }
 
 /*
@@ -1271,6 +1285,26 @@ static struct rmap_item *get_next_rmap_item(struct mm_slot *mm_slot,
 	return rmap_item;
 }
 
+/*
+ * Called at the end of each full scan: in adaptive mode, slow ksmd down
+ * while a full scan merges less than 1% of the pages tracked, and bring
+ * it back to full speed once one merges more.
+ */
+static void ksm_adapt_scan_rate(void)
+{
+	unsigned long merged = ksm_pages_shared + ksm_pages_sharing;
+	long gain = merged - ksm_scan_start_merged;
+
+	ksm_scan_start_merged = merged;
+
+	if (!ksm_thread_adaptive)
+		ksm_sleep_shift = 0;
+	else if (gain > 0 && gain * 100 >= ksm_rmap_items)
+		ksm_sleep_shift = 0;
+	else if (ksm_sleep_shift < KSM_SLEEP_SHIFT_MAX)
+		ksm_sleep_shift++;
+}
+
 static struct rmap_item *scan_get_next_rmap_item(struct page **page)
 {
 	struct mm_struct *mm;
@@ -1399,6 +1433,7 @@ next_mm:
 		goto next_mm;
 
 	ksm_scan.seqnr++;
+	ksm_adapt_scan_rate();
 	return NULL;
 }
 
@@ -1442,7 +1477,8 @@ static int ksm_scan_thread(void *nothing)
 
 		if (ksmd_should_run()) {
 			schedule_timeout_interruptible(
-				msecs_to_jiffies(ksm_thread_sleep_millisecs));
+				msecs_to_jiffies(ksm_thread_sleep_millisecs <<
+						 ksm_sleep_shift));
 		} else {
 			wait_event_freezable(ksm_thread_wait,
 				ksmd_should_run() || kthread_should_stop());
@@ -1451,6 +1487,12 @@ static int ksm_scan_thread(void *nothing)
 	return 0;
 }
 
+/* Areas whose pages ksmd leaves alone */
+#define VM_KSM_UNMERGEABLE	(VM_SHARED    | VM_MAYSHARE | VM_PFNMAP   | \
+				 VM_IO        | VM_DONTEXPAND | VM_RESERVED | \
+				 VM_HUGETLB   | VM_INSERTPAGE | VM_NONLINEAR | \
+				 VM_MIXEDMAP  | VM_SAO)
+
 int ksm_madvise(struct vm_area_struct *vma, unsigned long start,
 		unsigned long end, int advice, unsigned long *vm_flags)
 {
@@ -1462,10 +1504,7 @@ int ksm_madvise(struct vm_area_struct *vma, unsigned long start,
 		/*
 		 * Be somewhat over-protective for now!
 		 */
-		if (*vm_flags & (VM_MERGEABLE | VM_SHARED  | VM_MAYSHARE   |
-				 VM_PFNMAP    | VM_IO      | VM_DONTEXPAND |
-				 VM_RESERVED  | VM_HUGETLB | VM_INSERTPAGE |
-				 VM_NONLINEAR | VM_MIXEDMAP | VM_SAO))
+		if (*vm_flags & (VM_MERGEABLE | VM_KSM_UNMERGEABLE))
 			return 0;		/* just ignore the advice */
 
 		if (!test_bit(MMF_VM_MERGEABLE, &mm->flags)) {
@@ -1519,12 +1558,51 @@ int __ksm_enter(struct mm_struct *mm)
 	set_bit(MMF_VM_MERGEABLE, &mm->flags);
 	atomic_inc(&mm->mm_count);
 
+	/* There is something new to merge: don't make it wait */
+	ksm_sleep_shift = 0;
+
 	if (needs_wakeup)
 		wake_up_interruptible(&ksm_thread_wait);
 
 	return 0;
 }
 
+/*
+ * Make all anonymous memory of @mm mergeable, now and when mapped later,
+ * as if the process had madvised it MADV_MERGEABLE.
+ */
+int ksm_merge_any(struct mm_struct *mm)
+{
+	struct vm_area_struct *vma;
+	int err = 0;
+
+	down_write(&mm->mmap_sem);
+	if (test_bit(MMF_VM_MERGE_ANY, &mm->flags))
+		goto out;
+
+	for (vma = mm->mmap; vma; vma = vma->vm_next) {
+		if (vma->vm_file)
+			continue;
+		err = ksm_madvise(vma, vma->vm_start, vma->vm_end,
+				  MADV_MERGEABLE, &vma->vm_flags);
+		if (err)
+			goto out;
+	}
+	set_bit(MMF_VM_MERGE_ANY, &mm->flags);
+out:
+	up_write(&mm->mmap_sem);
+	return err;
+}
+
+unsigned long __ksm_mmap_flags(struct mm_struct *mm, unsigned long vm_flags)
+{
+	if (vm_flags & VM_KSM_UNMERGEABLE)
+		return vm_flags;
+	if (!test_bit(MMF_VM_MERGEABLE, &mm->flags) && __ksm_enter(mm))
+		return vm_flags;
+	return vm_flags | VM_MERGEABLE;
+}
+
 void __ksm_exit(struct mm_struct *mm)
 {
 	struct mm_slot *mm_slot;
@@ -1871,6 +1949,40 @@ static ssize_t pages_to_scan_store(struct kobject *kobj,
 }
 KSM_ATTR(pages_to_scan);
 
+static ssize_t adaptive_show(struct kobject *kobj,
+			     struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", ksm_thread_adaptive);
+}
+
+static ssize_t adaptive_store(struct kobject *kobj,
+			      struct kobj_attribute *attr,
+			      const char *buf, size_t count)
+{
+	int err;
+	unsigned long adaptive;
+
+	err = strict_strtoul(buf, 10, &adaptive);
+	if (err || adaptive > 1)
+		return -EINVAL;
+
+	ksm_thread_adaptive = adaptive;
+	if (!adaptive)
+		ksm_sleep_shift = 0;
+
+	return count;
+}
+KSM_ATTR(adaptive);
+
+static ssize_t current_sleep_millisecs_show(struct kobject *kobj,
+					    struct kobj_attribute *attr,
+					    char *buf)
+{
+	return sprintf(buf, "%u\n",
+		       ksm_thread_sleep_millisecs << ksm_sleep_shift);
+}
+KSM_ATTR_RO(current_sleep_millisecs);
+
 static ssize_t run_show(struct kobject *kobj, struct kobj_attribute *attr,
 			char *buf)
 {
@@ -1966,6 +2078,8 @@ KSM_ATTR_RO(full_scans);
 static struct attribute *ksm_attrs[] = {
 	&sleep_millisecs_attr.attr,
 	&pages_to_scan_attr.attr,
+	&adaptive_attr.attr,
+	&current_sleep_millisecs_attr.attr,
 	&run_attr.attr,
 	&pages_shared_attr.attr,
 	&pages_sharing_attr.attr,
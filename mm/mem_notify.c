@@ -0,0 +1,234 @@
+/*
+ * linux/mm/mem_notify.c
+ *
+ * Low memory notification: tell userspace how hard page reclaim has to
+ * work, so that it can trim caches or kill applications before the
+ * system starts thrashing or the OOM killer steps in.
+ *
+ * Reclaim pressure is the share of the pages scanned by shrink_zone()
+ * that could not be reclaimed, computed every MEM_NOTIFY_WINDOW pages
+ * scanned, and mapped onto a level by vm.mem_notify_{medium,critical}.
+ * Tasks poll /dev/mem_notify for the levels they care about; see
+ * Documentation/vm/mem_notify.txt.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/fs.h>
+#include <linux/gfp.h>
+#include <linux/mem_notify.h>
+#include <linux/miscdevice.h>
+#include <linux/poll.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+#include <linux/swap.h>
+#include <linux/uaccess.h>
+#include <linux/wait.h>
+
+/* Pages to scan before the pressure is computed */
+#define MEM_NOTIFY_WINDOW	(SWAP_CLUSTER_MAX * 16)
+
+int sysctl_mem_notify_medium = 60;
+int sysctl_mem_notify_critical = 95;
+
+static const char *mem_notify_names[NR_MEM_NOTIFY_LEVELS] = {
+	[MEM_NOTIFY_LOW]	= "low",
+	[MEM_NOTIFY_MEDIUM]	= "medium",
+	[MEM_NOTIFY_CRITICAL]	= "critical",
+};
+
+static DEFINE_SPINLOCK(mem_notify_lock);
+static unsigned long mem_notify_scanned;
+static unsigned long mem_notify_reclaimed;
+/* Number of windows which ended at each level, under mem_notify_lock */
+static unsigned long mem_notify_events[NR_MEM_NOTIFY_LEVELS];
+static DECLARE_WAIT_QUEUE_HEAD(mem_notify_wait);
+
+/* What one opener of /dev/mem_notify waits for and has been told */
+struct mem_notify_file {
+	enum mem_notify_level level;
+	unsigned long seen[NR_MEM_NOTIFY_LEVELS];
+};
+
+static enum mem_notify_level mem_notify_level(unsigned long pressure)
+{
+	if (pressure >= sysctl_mem_notify_critical)
+		return MEM_NOTIFY_CRITICAL;
+	if (pressure >= sysctl_mem_notify_medium)
+		return MEM_NOTIFY_MEDIUM;
+	return MEM_NOTIFY_LOW;
+}
+
+/*
+ * Called by shrink_zone() with the number of pages it scanned and
+ * reclaimed, for global reclaim only.
+ */
+void mem_notify_vmscan(gfp_t gfp_mask, unsigned long scanned,
+		       unsigned long reclaimed)
+{
+	unsigned long pressure = 0;
+	enum mem_notify_level level;
+
+	/*
+	 * Allocations which cannot do I/O nor use highmem or movable
+	 * pages only scan a small part of memory: the pressure they see
+	 * says little about the system as a whole.
+	 */
+	if (!(gfp_mask & (__GFP_HIGHMEM | __GFP_MOVABLE | __GFP_IO | __GFP_FS)))
+		return;
+	if (!scanned)
+		return;
+
+	spin_lock(&mem_notify_lock);
+	mem_notify_scanned += scanned;
+	mem_notify_reclaimed += reclaimed;
+	if (mem_notify_scanned < MEM_NOTIFY_WINDOW) {
+		spin_unlock(&mem_notify_lock);
+		return;
+	}
+
+	if (mem_notify_reclaimed < mem_notify_scanned)
+		pressure = 100 - mem_notify_reclaimed * 100 /
+				 mem_notify_scanned;
+	mem_notify_scanned = 0;
+	mem_notify_reclaimed = 0;
+
+	level = mem_notify_level(pressure);
+	mem_notify_events[level]++;
+	spin_unlock(&mem_notify_lock);
+
+	if (waitqueue_active(&mem_notify_wait))
+		wake_up_interruptible(&mem_notify_wait);
+}
+
+/*
+ * Return the highest level, at or above the one the file waits for,
+ * reached since it last read, or -1; with @consume, mark all as read.
+ */
+static int mem_notify_pending(struct mem_notify_file *mf, bool consume)
+{
+	int level, ret = -1;
+
+	spin_lock(&mem_notify_lock);
+	for (level = NR_MEM_NOTIFY_LEVELS - 1; level >= (int)mf->level; level--)
+		if (mem_notify_events[level] != mf->seen[level]) {
+			ret = level;
+			break;
+		}
+	if (consume)
+		memcpy(mf->seen, mem_notify_events, sizeof(mf->seen));
+	spin_unlock(&mem_notify_lock);
+
+	return ret;
+}
+
+static int mem_notify_open(struct inode *inode, struct file *file)
+{
+	struct mem_notify_file *mf;
+
+	mf = kzalloc(sizeof(*mf), GFP_KERNEL);
+	if (!mf)
+		return -ENOMEM;
+
+	mf->level = MEM_NOTIFY_LOW;
+	mem_notify_pending(mf, true);
+	file->private_data = mf;
+
+	return nonseekable_open(inode, file);
+}
+
+static int mem_notify_release(struct inode *inode, struct file *file)
+{
+	kfree(file->private_data);
+	return 0;
+}
+
+static ssize_t mem_notify_read(struct file *file, char __user *buf,
+			       size_t count, loff_t *ppos)
+{
+	struct mem_notify_file *mf = file->private_data;
+	char name[16];
+	size_t len;
+	int level;
+
+	for (;;) {
+		level = mem_notify_pending(mf, true);
+		if (level >= 0)
+			break;
+		if (file->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+		if (wait_event_interruptible(mem_notify_wait,
+				mem_notify_pending(mf, false) >= 0))
+			return -ERESTARTSYS;
+	}
+
+	len = snprintf(name, sizeof(name), "%s\n", mem_notify_names[level]);
+	if (count < len)
+		return -EINVAL;
+	if (copy_to_user(buf, name, len))
+		return -EFAULT;
+
+	return len;
+}
+
+/* Writing a level name selects the lowest level to be notified of */
+static ssize_t mem_notify_write(struct file *file, const char __user *buf,
+				size_t count, loff_t *ppos)
+{
+	struct mem_notify_file *mf = file->private_data;
+	char name[16];
+	int level;
+
+	if (count >= sizeof(name))
+		return -EINVAL;
+	if (copy_from_user(name, buf, count))
+		return -EFAULT;
+	name[count] = '\0';
+
+	for (level = 0; level < NR_MEM_NOTIFY_LEVELS; level++)
+		if (sysfs_streq(name, mem_notify_names[level]))
+			break;
+	if (level == NR_MEM_NOTIFY_LEVELS)
+		return -EINVAL;
+
+	mf->level = level;
+	mem_notify_pending(mf, true);
+
+	return count;
+}
+
+static unsigned int mem_notify_poll(struct file *file, poll_table *wait)
+{
+	struct mem_notify_file *mf = file->private_data;
+
+	poll_wait(file, &mem_notify_wait, wait);
+	if (mem_notify_pending(mf, false) >= 0)
+		return POLLIN | POLLRDNORM;
+
+	return 0;
+}
+
+static const struct file_operations mem_notify_fops = {
+	.owner		= THIS_MODULE,
+	.open		= mem_notify_open,
+	.release	= mem_notify_release,
+	.read		= mem_notify_read,
+	.write		= mem_notify_write,
+	.poll		= mem_notify_poll,
+	.llseek		= no_llseek,
+};
+
+static struct miscdevice mem_notify_dev = {
+	.minor	= MISC_DYNAMIC_MINOR,
+	.name	= "mem_notify",
+	.fops	= &mem_notify_fops,
+	.mode	= S_IRUGO | S_IWUGO,
+};
+
+static int __init mem_notify_init(void)
+{
+	return misc_register(&mem_notify_dev);
+}
+module_init(mem_notify_init);
@@ -48,6 +48,7 @@
 #include <linux/page_cgroup.h>
 #include <linux/cpu.h>
 #include <linux/oom.h>
+#include <linux/ksm.h>
 #include "internal.h"
 
 #include <asm/uaccess.h>
@@ -262,6 +263,13 @@ struct mem_cgroup {
 	 * mem_cgroup ? And what type of charges should we move ?
 	 */
 	unsigned long 	move_charge_at_immigrate;
+#ifdef CONFIG_KSM
+	/*
+	 * Should KSM merge all anonymous memory of the tasks in this
+	 * mem_cgroup, without them having to madvise it ?
+	 */
+	bool		ksm_merge_any;
+#endif
 	/*
 	 * percpu counter.
 	 */
@@ -4278,6 +4286,47 @@ static int mem_cgroup_oom_control_write(struct cgroup *cgrp,
 	return 0;
 }
 
+#ifdef CONFIG_KSM
+static u64 mem_cgroup_ksm_merge_any_read(struct cgroup *cgrp,
+					 struct cftype *cft)
+{
+	return mem_cgroup_from_cont(cgrp)->ksm_merge_any;
+}
+
+static void mem_cgroup_ksm_merge_task(struct task_struct *p,
+				      struct cgroup_scanner *scan)
+{
+	struct mm_struct *mm = get_task_mm(p);
+
+	if (mm) {
+		ksm_merge_any(mm);
+		mmput(mm);
+	}
+}
+
+static int mem_cgroup_ksm_merge_any_write(struct cgroup *cgrp,
+					  struct cftype *cft, u64 val)
+{
+	struct mem_cgroup *mem = mem_cgroup_from_cont(cgrp);
+	struct cgroup_scanner scan = {
+		.cg = cgrp,
+		.process_task = mem_cgroup_ksm_merge_task,
+	};
+
+	if (val > 1)
+		return -EINVAL;
+
+	/*
+	 * Tasks moved in later are handled by mem_cgroup_move_task(); tasks
+	 * already merging any memory keep doing so after it is cleared.
+	 */
+	mem->ksm_merge_any = val;
+	if (val)
+		return cgroup_scan_tasks(&scan);
+	return 0;
+}
+#endif
+
 static struct cftype mem_cgroup_files[] = {
 	{
 		.name = "usage_in_bytes",
@@ -4341,6 +4390,13 @@ static struct cftype mem_cgroup_files[] = {
 		.unregister_event = mem_cgroup_oom_unregister_event,
 		.private = MEMFILE_PRIVATE(_OOM_TYPE, OOM_CONTROL),
 	},
+#ifdef CONFIG_KSM
+	{
+		.name = "ksm_merge_any",
+		.read_u64 = mem_cgroup_ksm_merge_any_read,
+		.write_u64 = mem_cgroup_ksm_merge_any_write,
+	},
+#endif
 };
 
 #ifdef CONFIG_CGROUP_MEM_RES_CTLR_SWAP
@@ -4600,6 +4656,10 @@ mem_cgroup_create(struct cgroup_subsys *ss, struct cgroup *cont)
 
 	if (parent)
 		mem->swappiness = get_swappiness(parent);
+#ifdef CONFIG_KSM
+	if (parent)
+		mem->ksm_merge_any = parent->ksm_merge_any;
+#endif
 	atomic_set(&mem->refcnt, 1);
 	mem->move_charge_at_immigrate = 0;
 	mutex_init(&mem->thresholds_lock);
@@ -5117,6 +5177,16 @@ static void mem_cgroup_move_task(struct cgroup_subsys *ss,
 {
 	struct mm_struct *mm;
 
+#ifdef CONFIG_KSM
+	if (mem_cgroup_from_cont(cont)->ksm_merge_any) {
+		mm = get_task_mm(p);
+		if (mm) {
+			ksm_merge_any(mm);
+			mmput(mm);
+		}
+	}
+#endif
+
 	if (!mc.to)
 		/* no need to move charge */
 		return;
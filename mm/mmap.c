@@ -30,6 +30,7 @@
 #include <linux/perf_event.h>
 #include <linux/audit.h>
 #include <linux/khugepaged.h>
+#include <linux/ksm.h>
 
 #include <asm/uaccess.h>
 #include <asm/cacheflush.h>
@@ -1277,6 +1278,9 @@ munmap_back:
 		vm_flags |= VM_ACCOUNT;
 	}
 
+	if (!file)
+		vm_flags = ksm_mmap_flags(mm, vm_flags);
+
 	/*
 	 * Can we just expand an old mapping?
 	 */
@@ -2233,6 +2237,8 @@ unsigned long do_brk(unsigned long addr, unsigned long len)
 	if (security_vm_enough_memory(len >> PAGE_SHIFT))
 		return -ENOMEM;
 
+	flags = ksm_mmap_flags(mm, flags);
+
 	/* Can we just expand an old private anonymous mapping? */
 	vma = vma_merge(mm, prev, addr, addr + len, flags,
 					NULL, NULL, pgoff, NULL);
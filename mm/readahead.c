@@ -17,6 +17,7 @@
 #include <linux/task_io_accounting_ops.h>
 #include <linux/pagevec.h>
 #include <linux/pagemap.h>
+#include <linux/boot_prefetch.h>
 
 /*
  * Initialise a struct file's readahead state.  Assumes that the caller has
@@ -187,6 +188,12 @@ __do_page_cache_readahead(struct address_space *mapping, struct file *filp,
 		list_add(&page->lru, &page_pool);
 		if (page_idx == nr_to_read - lookahead_size)
 			SetPageReadahead(page);
+		/* Only readahead windows are speculative, see ra_submit() */
+		if (lookahead_size)
+			__SetPageRaUnused(page);
+		/* Adjacent pages are merged into one record */
+		if (filp)
+			boot_prefetch_record(filp, page_offset, 1);
 		ret++;
 	}
 
@@ -255,10 +262,71 @@ unsigned long ra_submit(struct file_ra_state *ra,
 
 	actual = __do_page_cache_readahead(mapping, filp,
 					ra->start, ra->size, ra->async_size);
+#ifdef CONFIG_READAHEAD_FEEDBACK
+	/*
+	 * Only count the pages marked PG_ra_unused, which can be hits:
+	 * not those of mmap read-around, which has no lookahead.
+	 */
+	if (ra->async_size) {
+		ra->ra_issued += actual;
+		count_vm_events(READAHEAD_PAGES, actual);
+	}
+#endif
 
 	return actual;
 }
 
+#ifdef CONFIG_READAHEAD_FEEDBACK
+/*
+ * Readahead feedback.
+ *
+ * Pages of the readahead windows ra_submit() reads, but not those of mmap
+ * read-around, are marked PG_ra_unused until they are first accessed
+ * through a file_ra_state, which counts them in ra_hits, or leave the page
+ * cache, which counts them as wasted.  Once a file has read ahead
+ * at least its maximum window, the pages of all but the last window should
+ * have been used: if less than half were, halve the window limit of the
+ * file, down to 1/16 of ra_pages; if most were, double it again.
+ */
+#define RA_SHIFT_MAX	4
+
+void __readahead_hit(struct file_ra_state *ra, struct page *page)
+{
+	if (TestClearPageRaUnused(page)) {
+		ra->ra_hits++;
+		count_vm_event(READAHEAD_HIT);
+	}
+}
+EXPORT_SYMBOL_GPL(__readahead_hit);
+
+static unsigned long ra_feedback_max(struct file_ra_state *ra)
+{
+	unsigned int done, hits;
+
+	/* The last window is still being consumed */
+	done = ra->ra_issued > ra->size ? ra->ra_issued - ra->size : 0;
+	if (done && done >= ra->ra_pages) {
+		hits = min(ra->ra_hits, done);
+		if (hits < done / 2) {
+			if (ra->ra_shift < RA_SHIFT_MAX)
+				ra->ra_shift++;
+		} else if (hits >= done - done / 8) {
+			if (ra->ra_shift)
+				ra->ra_shift--;
+		}
+		ra->ra_issued -= done;
+		ra->ra_hits -= hits;
+	}
+
+	return max(ra->ra_pages >> ra->ra_shift, 1U);
+}
+#else
+static inline unsigned long ra_feedback_max(struct file_ra_state *ra)
+{
+	return ra->ra_pages;
+}
+#endif
+
 /*
  * Set the initial window size, round to next power of 2 and square
  * for small size, x 4 for medium, and x 2 for large
@@ -398,7 +466,7 @@ ondemand_readahead(struct address_space *mapping,
 		   bool hit_readahead_marker, pgoff_t offset,
 		   unsigned long req_size)
 {
-	unsigned long max = max_sane_readahead(ra->ra_pages);
+	unsigned long max = max_sane_readahead(ra_feedback_max(ra));
 
 	/*
 	 * start of file
@@ -78,6 +78,9 @@ static inline struct anon_vma *anon_vma_alloc(void)
 		 * from fork, the root will be reset to the parents anon_vma.
 		 */
 		anon_vma->root = anon_vma;
+#ifdef CONFIG_SWAP
+		anon_vma->swap_cursor = 0;
+#endif
 	}
 
 	return anon_vma;
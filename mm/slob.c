@@ -15,8 +15,13 @@
  * The slob heap is a set of linked list of pages from alloc_pages(),
  * and within each page, there is a singly-linked list of free blocks
  * (slob_t). The heap is grown on demand. To reduce fragmentation,
- * heap pages are segregated into three lists, with objects less than
- * 256 bytes, objects less than 1024 bytes, and all other objects.
+ * heap pages are segregated by size class: each page only holds objects
+ * of up to 16, 32, 64, ... 2048 bytes, or all larger objects, depending
+ * on the size of the object it was allocated for. There is a list of
+ * partially free pages for each class, and pages leave it while they
+ * have less room left than the smallest object of their class, so that
+ * allocations don't walk through the many pages which can't satisfy
+ * them.
  *
  * Allocation from heap involves first searching for a page with
  * sufficient free blocks (using a next-fit-like approach) followed by
@@ -41,7 +46,9 @@
  * calling alloc_pages(). As SLAB objects know their size, no separate
  * size bookkeeping is necessary and there is essentially no allocation
  * space overhead, and compound pages aren't needed for multi-page
- * allocations.
+ * allocations. Each cache keeps a few recently freed objects, up to
+ * SLOB_STASH_BYTES worth, and hands them out again without going
+ * through the heap at all.
  *
  * NUMA support in SLOB is fairly simplistic, pushing most of the real
  * logic down to the page allocator, and simply doing the node accounting
@@ -102,7 +109,8 @@ struct slob_page {
 			unsigned long flags;	/* mandatory */
 			atomic_t _count;	/* mandatory */
 			slobidx_t units;	/* free units left in page */
-			unsigned long pad[2];
+			unsigned long class;	/* size class of its blocks */
+			unsigned long pad;
 			slob_t *free;		/* first free slob_t in page */
 			struct list_head list;	/* linked list of free pages */
 		};
@@ -122,13 +130,17 @@ static inline void free_slob_page(struct slob_page *sp)
 }
 
 /*
- * All partially free slob pages go on these lists.
+ * All partially free slob pages go on these lists, one per size class:
+ * class n is for blocks of up to 16 << n bytes, the last one for all
+ * larger blocks.
  */
-#define SLOB_BREAK1 256
-#define SLOB_BREAK2 1024
-static LIST_HEAD(free_slob_small);
-static LIST_HEAD(free_slob_medium);
-static LIST_HEAD(free_slob_large);
+#define SLOB_CLASSES 9
+#define SLOB_CLASS_INIT(n) LIST_HEAD_INIT(slob_classes[n])
+static struct list_head slob_classes[SLOB_CLASSES] = {
+	SLOB_CLASS_INIT(0), SLOB_CLASS_INIT(1), SLOB_CLASS_INIT(2),
+	SLOB_CLASS_INIT(3), SLOB_CLASS_INIT(4), SLOB_CLASS_INIT(5),
+	SLOB_CLASS_INIT(6), SLOB_CLASS_INIT(7), SLOB_CLASS_INIT(8),
+};
 
 /*
  * is_slob_page: True for all slob pages (false for bigblock pages)
@@ -177,6 +189,23 @@ static inline void clear_slob_page_free(struct slob_page *sp)
 #define SLOB_UNITS(size) (((size) + SLOB_UNIT - 1)/SLOB_UNIT)
 #define SLOB_ALIGN L1_CACHE_BYTES
 
+/*
+ * Size class of a block of the given size.
+ */
+static inline int slob_class(size_t size)
+{
+	return min_t(int, fls((size - 1) >> 4), SLOB_CLASSES - 1);
+}
+
+/*
+ * Size of the smallest block of a size class, in units: pages of
+ * that class with less room left are kept off the free list.
+ */
+static inline slobidx_t slob_class_min_units(int class)
+{
+	return class ? SLOB_UNITS((8 << class) + 1) : 1;
+}
+
 /*
  * struct slob_rcu is inserted at the tail of allocated slob blocks, which
  * were created with a SLAB_DESTROY_BY_RCU slab. slob_rcu is used to free
@@ -306,7 +335,7 @@ static void *slob_page_alloc(struct slob_page *sp, size_t size, int align)
 			}
 
 			sp->units -= units;
-			if (!sp->units)
+			if (sp->units < slob_class_min_units(sp->class))
 				clear_slob_page_free(sp);
 			return cur;
 		}
@@ -325,13 +354,9 @@ static void *slob_alloc(size_t size, gfp_t gfp, int align, int node)
 	struct list_head *slob_list;
 	slob_t *b = NULL;
 	unsigned long flags;
+	int class = slob_class(size);
 
-	if (size < SLOB_BREAK1)
-		slob_list = &free_slob_small;
-	else if (size < SLOB_BREAK2)
-		slob_list = &free_slob_medium;
-	else
-		slob_list = &free_slob_large;
+	slob_list = &slob_classes[class];
 
 	spin_lock_irqsave(&slob_lock, flags);
 	/* Iterate through each partially free page, try to find room */
@@ -374,6 +399,7 @@ static void *slob_alloc(size_t size, gfp_t gfp, int align, int node)
 
 		spin_lock_irqsave(&slob_lock, flags);
 		sp->units = SLOB_UNITS(PAGE_SIZE);
+		sp->class = class;
 		sp->free = b;
 		INIT_LIST_HEAD(&sp->list);
 		set_slob(b, SLOB_UNITS(PAGE_SIZE), b + SLOB_UNITS(PAGE_SIZE));
@@ -396,7 +422,6 @@ static void slob_free(void *block, int size)
 	slob_t *prev, *next, *b = (slob_t *)block;
 	slobidx_t units;
 	unsigned long flags;
-	struct list_head *slob_list;
 
 	if (unlikely(ZERO_OR_NULL_PTR(block)))
 		return;
@@ -418,20 +443,13 @@ static void slob_free(void *block, int size)
 		return;
 	}
 
-	if (!slob_page_free(sp)) {
+	if (!sp->units) {
 		/* This slob page is about to become partially free. Easy! */
 		sp->units = units;
 		sp->free = b;
 		set_slob(b, units,
 			(void *)((unsigned long)(b +
 					SLOB_UNITS(PAGE_SIZE)) & PAGE_MASK));
-		if (size < SLOB_BREAK1)
-			slob_list = &free_slob_small;
-		else if (size < SLOB_BREAK2)
-			slob_list = &free_slob_medium;
-		else
-			slob_list = &free_slob_large;
-		set_slob_page_free(sp, slob_list);
 		goto out;
 	}
 
@@ -469,6 +487,10 @@ static void slob_free(void *block, int size)
 			set_slob(prev, slob_units(prev), b);
 	}
 out:
+	/* Back on the free list once it has room for a block of its class */
+	if (!slob_page_free(sp) &&
+			sp->units >= slob_class_min_units(sp->class))
+		set_slob_page_free(sp, &slob_classes[sp->class]);
 	spin_unlock_irqrestore(&slob_lock, flags);
 }
 
@@ -557,13 +579,79 @@ size_t ksize(const void *block)
 }
 EXPORT_SYMBOL(ksize);
 
+/*
+ * Recently freed objects a cache keeps for reuse: no more than
+ * SLOB_STASH_MAX of them, nor more than SLOB_STASH_BYTES in all.
+ */
+#define SLOB_STASH_MAX 8
+#define SLOB_STASH_BYTES 512
+
 struct kmem_cache {
 	unsigned int size, align;
 	unsigned long flags;
 	const char *name;
 	void (*ctor)(void *);
+	spinlock_t stash_lock;	/* protects the following */
+	void *stash;		/* free objects, linked through their first word */
+	unsigned int stash_nr, stash_max;
 };
 
+/*
+ * Take an object out of the cache's stash, if there is one.
+ */
+static void *slob_stash_get(struct kmem_cache *c)
+{
+	void *b;
+	unsigned long flags;
+
+	if (!c->stash_max)
+		return NULL;
+
+	spin_lock_irqsave(&c->stash_lock, flags);
+	b = c->stash;
+	if (b) {
+		c->stash = *(void **)b;
+		c->stash_nr--;
+	}
+	spin_unlock_irqrestore(&c->stash_lock, flags);
+
+	return b;
+}
+
+/*
+ * Keep a freed object in the cache's stash. Returns 0 if it is full.
+ */
+static int slob_stash_put(struct kmem_cache *c, void *b)
+{
+	int ret = 0;
+	unsigned long flags;
+
+	if (!c->stash_max)
+		return 0;
+
+	spin_lock_irqsave(&c->stash_lock, flags);
+	if (c->stash_nr < c->stash_max) {
+		*(void **)b = c->stash;
+		c->stash = b;
+		c->stash_nr++;
+		ret = 1;
+	}
+	spin_unlock_irqrestore(&c->stash_lock, flags);
+
+	return ret;
+}
+
+/*
+ * Give the objects in the cache's stash back to the heap.
+ */
+static void slob_stash_drain(struct kmem_cache *c)
+{
+	void *b;
+
+	while ((b = slob_stash_get(c)))
+		slob_free(b, c->size);
+}
+
 struct kmem_cache *kmem_cache_create(const char *name, size_t size,
 	size_t align, unsigned long flags, void (*ctor)(void *))
 {
@@ -581,6 +669,19 @@ struct kmem_cache *kmem_cache_create(const char *name, size_t size,
 		}
 		c->flags = flags;
 		c->ctor = ctor;
+		spin_lock_init(&c->stash_lock);
+		c->stash = NULL;
+		c->stash_nr = 0;
+		/*
+		 * Objects freed by RCU don't go through kmem_cache_free()
+		 * and don't need a stash; nor do page-sized ones.
+		 */
+		c->stash_max = 0;
+		if (!(flags & SLAB_DESTROY_BY_RCU) &&
+				c->size >= sizeof(void *) &&
+				c->size < PAGE_SIZE)
+			c->stash_max = min_t(unsigned int, SLOB_STASH_MAX,
+					SLOB_STASH_BYTES / c->size);
 		/* ignore alignment unless it's forced */
 		c->align = (flags & SLAB_HWCACHE_ALIGN) ? SLOB_ALIGN : 0;
 		if (c->align < ARCH_SLAB_MINALIGN)
@@ -600,16 +701,24 @@ void kmem_cache_destroy(struct kmem_cache *c)
 	kmemleak_free(c);
 	if (c->flags & SLAB_DESTROY_BY_RCU)
 		rcu_barrier();
+	slob_stash_drain(c);
 	slob_free(c, sizeof(struct kmem_cache));
 }
 EXPORT_SYMBOL(kmem_cache_destroy);
 
 void *kmem_cache_alloc_node(struct kmem_cache *c, gfp_t flags, int node)
 {
-	void *b;
+	void *b = NULL;
 
 	if (c->size < PAGE_SIZE) {
-		b = slob_alloc(c->size, flags, c->align, node);
+		/* Stashed objects may come from any node */
+		if (node == -1) {
+			b = slob_stash_get(c);
+			if (b && unlikely(flags & __GFP_ZERO))
+				memset(b, 0, c->size);
+		}
+		if (!b)
+			b = slob_alloc(c->size, flags, c->align, node);
 		trace_kmem_cache_alloc_node(_RET_IP_, b, c->size,
 					    SLOB_UNITS(c->size) * SLOB_UNIT,
 					    flags, node);
@@ -652,7 +761,7 @@ void kmem_cache_free(struct kmem_cache *c, void *b)
 		slob_rcu = b + (c->size - sizeof(struct slob_rcu));
 		slob_rcu->size = c->size;
 		call_rcu(&slob_rcu->head, kmem_rcu_free);
-	} else {
+	} else if (!slob_stash_put(c, b)) {
 		__kmem_cache_free(b, c->size);
 	}
 
@@ -668,6 +777,7 @@ EXPORT_SYMBOL(kmem_cache_size);
 
 int kmem_cache_shrink(struct kmem_cache *d)
 {
+	slob_stash_drain(d);
 	return 0;
 }
 EXPORT_SYMBOL(kmem_cache_shrink);
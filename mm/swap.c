@@ -37,6 +37,12 @@
 /* How many pages do we try to swap or page in/out together? */
 int page_cluster;
 
+/*
+ * Swap slots kept for each anon_vma's run of swapped out pages, and
+ * whether swapin readahead follows the faulting address: 0 is off.
+ */
+int swap_locality;
+
 static DEFINE_PER_CPU(struct pagevec[NR_LRU_LISTS], lru_add_pvecs);
 static DEFINE_PER_CPU(struct pagevec, lru_rotate_pvecs);
 static DEFINE_PER_CPU(struct pagevec, lru_deactivate_pvecs);
@@ -19,6 +19,7 @@
 #include <linux/pagevec.h>
 #include <linux/migrate.h>
 #include <linux/page_cgroup.h>
+#include <linux/rmap.h>
 
 #include <asm/pgtable.h>
 
@@ -135,6 +136,39 @@ void __delete_from_swap_cache(struct page *page)
 	INC_CACHE_INFO(del_total);
 }
 
+/*
+ * With swap_locality set, allocate swap for the pages of each anon_vma
+ * in runs of contiguous slots, rather than in the order reclaim comes
+ * across them, so that swapin_readahead() can read the pages of a VMA
+ * back with a few sequential reads.
+ */
+static swp_entry_t get_swap_page_anon(struct page *page)
+{
+	struct anon_vma *anon_vma;
+	swp_entry_t entry;
+
+	if (!swap_locality)
+		return get_swap_page();
+
+	/*
+	 * The anon_vma may be freed if the page is being unmapped, but
+	 * SLAB_DESTROY_BY_RCU keeps it an anon_vma: the worst we can do
+	 * is to give a poor hint to another one.
+	 */
+	rcu_read_lock();
+	anon_vma = page_anon_vma(page);
+	if (anon_vma) {
+		entry.val = ACCESS_ONCE(anon_vma->swap_cursor);
+		entry = get_swap_page_after(entry);
+		if (entry.val)
+			anon_vma->swap_cursor = entry.val;
+	} else
+		entry = get_swap_page();
+	rcu_read_unlock();
+
+	return entry;
+}
+
 /**
  * add_to_swap - allocate swap space for a page
  * @page: page we want to move to swap
@@ -150,7 +184,7 @@ int add_to_swap(struct page *page)
 	VM_BUG_ON(!PageLocked(page));
 	VM_BUG_ON(!PageUptodate(page));
 
-	entry = get_swap_page();
+	entry = get_swap_page_anon(page);
 	if (!entry.val)
 		return 0;
 
@@ -352,6 +386,84 @@ struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
 	return found_page;
 }
 
+#define SWAP_RA_VMA_MAX	32	/* pages */
+
+/*
+ * Collect the swap entries of the ptes around addr in vma: an aligned
+ * block of (1 << page_cluster) pages, within the vma and the page table
+ * holding addr. Returns their number, the first being for address
+ * *start, and entries[i] is 0 where the pte isn't swapped out.
+ */
+static int swapin_ra_vma_entries(struct vm_area_struct *vma, unsigned long addr,
+				 swp_entry_t *entries, unsigned long *start)
+{
+	struct mm_struct *mm = vma->vm_mm;
+	unsigned long window, end;
+	pgd_t *pgd;
+	pud_t *pud;
+	pmd_t *pmd;
+	pte_t *pte;
+	spinlock_t *ptl;
+	int i, nr_pages;
+
+	window = min(1UL << page_cluster, (unsigned long)SWAP_RA_VMA_MAX)
+			<< PAGE_SHIFT;
+	*start = max3(addr & ~(window - 1), addr & PMD_MASK, vma->vm_start);
+	end = min3((addr & ~(window - 1)) + window,
+		   (addr & PMD_MASK) + PMD_SIZE, vma->vm_end);
+	nr_pages = (end - *start) >> PAGE_SHIFT;
+
+	pgd = pgd_offset(mm, addr);
+	if (pgd_none_or_clear_bad(pgd))
+		return 0;
+	pud = pud_offset(pgd, addr);
+	if (pud_none_or_clear_bad(pud))
+		return 0;
+	pmd = pmd_offset(pud, addr);
+	if (pmd_none(*pmd) || pmd_trans_huge(*pmd) || pmd_bad(*pmd))
+		return 0;
+
+	pte = pte_offset_map_lock(mm, pmd, *start, &ptl);
+	for (i = 0; i < nr_pages; i++) {
+		pte_t ptent = pte[i];
+
+		entries[i].val = 0;
+		if (pte_none(ptent) || pte_present(ptent) || pte_file(ptent))
+			continue;
+		entries[i] = pte_to_swp_entry(ptent);
+		/* Migration and hwpoison entries aren't swap */
+		if (non_swap_entry(entries[i]))
+			entries[i].val = 0;
+	}
+	pte_unmap_unlock(pte, ptl);
+
+	return nr_pages;
+}
+
+/*
+ * Read ahead the swapped out pages around the faulting address rather
+ * than around the swap offset: these are the pages likely to be needed
+ * next, and with swap_locality they tend to be contiguous in swap.
+ */
+static void swapin_ra_vma(swp_entry_t entry, gfp_t gfp_mask,
+			  struct vm_area_struct *vma, unsigned long addr)
+{
+	swp_entry_t entries[SWAP_RA_VMA_MAX];
+	unsigned long start;
+	struct page *page;
+	int i, nr_pages;
+
+	nr_pages = swapin_ra_vma_entries(vma, addr, entries, &start);
+	for (i = 0; i < nr_pages; i++, start += PAGE_SIZE) {
+		if (!entries[i].val || entries[i].val == entry.val)
+			continue;
+		page = read_swap_cache_async(entries[i], gfp_mask, vma, start);
+		if (!page)
+			break;
+		page_cache_release(page);
+	}
+}
+
 /**
  * swapin_readahead - swap in pages in hope we need them soon
  * @entry: swap entry of this memory
@@ -369,6 +481,9 @@ struct page *read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
  * This has been extended to use the NUMA policies from the mm triggering
  * the readahead.
  *
+ * With swap_locality set, the pages around addr in vma are read instead,
+ * when the fault is on a user mapping.
+ *
  * Caller must hold down_read on the vma->vm_mm if vma is not NULL.
  */
 struct page *swapin_readahead(swp_entry_t entry, gfp_t gfp_mask,
@@ -379,6 +494,11 @@ struct page *swapin_readahead(swp_entry_t entry, gfp_t gfp_mask,
 	unsigned long offset;
 	unsigned long end_offset;
 
+	if (swap_locality && page_cluster && vma && vma->vm_mm) {
+		swapin_ra_vma(entry, gfp_mask, vma, addr);
+		goto out;
+	}
+
 	/*
 	 * Get starting offset for readaround, and number of pages to read.
 	 * Adjust starting address by readbehind (for NUMA interleave case)?
@@ -395,6 +515,7 @@ struct page *swapin_readahead(swp_entry_t entry, gfp_t gfp_mask,
 			break;
 		page_cache_release(page);
 	}
+out:
 	lru_add_drain();	/* Push any new pages onto the LRU now */
 	return read_swap_cache_async(entry, gfp_mask, vma, addr);
 }
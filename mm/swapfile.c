@@ -179,6 +179,24 @@ static int wait_for_discard(void *word)
 #define SWAPFILE_CLUSTER	256
 #define LATENCY_LIMIT		256
 
+/*
+ * Mark the free swap slot at offset as allocated. Called with swap_lock.
+ */
+static void swap_slot_alloc(struct swap_info_struct *si, unsigned long offset,
+			    unsigned char usage)
+{
+	if (offset == si->lowest_bit)
+		si->lowest_bit++;
+	if (offset == si->highest_bit)
+		si->highest_bit--;
+	si->inuse_pages++;
+	if (si->inuse_pages == si->pages) {
+		si->lowest_bit = si->max;
+		si->highest_bit = 0;
+	}
+	si->swap_map[offset] = usage;
+}
+
 static unsigned long scan_swap_map(struct swap_info_struct *si,
 				   unsigned char usage)
 {
@@ -302,16 +320,7 @@ checks:
 	if (si->swap_map[offset])
 		goto scan;
 
-	if (offset == si->lowest_bit)
-		si->lowest_bit++;
-	if (offset == si->highest_bit)
-		si->highest_bit--;
-	si->inuse_pages++;
-	if (si->inuse_pages == si->pages) {
-		si->lowest_bit = si->max;
-		si->highest_bit = 0;
-	}
-	si->swap_map[offset] = usage;
+	swap_slot_alloc(si, offset, usage);
 	si->cluster_next = offset + 1;
 	si->flags -= SWP_SCANNING;
 
@@ -450,6 +459,48 @@ noswap:
 	return (swp_entry_t) {0};
 }
 
+/**
+ * get_swap_page_after - allocate swap entry next to another one
+ * @prev: swap entry to follow, or 0
+ *
+ * Allocate the slot right after @prev for the swap cache if it is free,
+ * so that a run of pages ends up contiguous in swap. Otherwise allocate
+ * a slot as get_swap_page() does, to start a new run, and keep the next
+ * swap_locality - 1 slots out of the way of get_swap_page() for a while.
+ */
+swp_entry_t get_swap_page_after(swp_entry_t prev)
+{
+	struct swap_info_struct *si;
+	unsigned long offset = swp_offset(prev) + 1;
+	int type = swp_type(prev);
+	swp_entry_t entry;
+
+	spin_lock(&swap_lock);
+	if (prev.val && type < nr_swapfiles && nr_swap_pages > 0) {
+		si = swap_info[type];
+		/* Don't get in the way of a free cluster search, see above */
+		if ((si->flags & SWP_WRITEOK) && !si->lowest_alloc &&
+		    offset >= si->lowest_bit && offset <= si->highest_bit &&
+		    !si->swap_map[offset]) {
+			nr_swap_pages--;
+			swap_slot_alloc(si, offset, SWAP_HAS_CACHE);
+			spin_unlock(&swap_lock);
+			return swp_entry(type, offset);
+		}
+	}
+	spin_unlock(&swap_lock);
+
+	entry = get_swap_page();
+	if (entry.val && swap_locality > 1) {
+		spin_lock(&swap_lock);
+		si = swap_info[swp_type(entry)];
+		if (si->cluster_next == swp_offset(entry) + 1)
+			si->cluster_next += swap_locality - 1;
+		spin_unlock(&swap_lock);
+	}
+	return entry;
+}
+
 /* The only caller of this function is now susupend routine */
 swp_entry_t get_swap_page_of_type(int type)
 {
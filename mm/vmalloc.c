@@ -18,6 +18,7 @@
 #include <linux/interrupt.h>
 #include <linux/proc_fs.h>
 #include <linux/seq_file.h>
+#include <linux/debugfs.h>
 #include <linux/debugobjects.h>
 #include <linux/kallsyms.h>
 #include <linux/list.h>
@@ -533,6 +534,28 @@ static void vmap_debug_free_range(unsigned long start, unsigned long end)
 #endif
 }
 
+#ifdef CONFIG_DEBUG_FS
+/* Exported in debugfs, to help tune lazy_max_pages() */
+static struct {
+	atomic_long_t purges;		/* purges which unmapped lazy areas */
+	atomic_long_t sync_purges;	/* ... of which were synchronous */
+	atomic_long_t purged_pages;
+	atomic_long_t tlb_flushes;
+	atomic_long_t blocks_new;
+	atomic_long_t blocks_freed;
+	atomic_long_t vb_allocs;
+	atomic_long_t vb_frees;
+} vmap_stats;
+
+/* Overrides lazy_max_pages() if set */
+static u32 vmap_lazy_max_pages;
+
+#define vmap_stat_add(item, n)	atomic_long_add(n, &vmap_stats.item)
+#else
+#define vmap_stat_add(item, n)	do { } while (0)
+#endif
+#define vmap_stat_inc(item)	vmap_stat_add(item, 1)
+
 /*
  * lazy_max_pages is the maximum amount of virtual address space we gather up
  * before attempting to purge with a TLB flush.
@@ -553,6 +576,10 @@ static unsigned long lazy_max_pages(void)
 {
 	unsigned int log;
 
+#ifdef CONFIG_DEBUG_FS
+	if (vmap_lazy_max_pages)
+		return vmap_lazy_max_pages;
+#endif
 	log = fls(num_online_cpus());
 
 	return log * (32UL * 1024 * 1024 / PAGE_SIZE);
@@ -572,6 +599,24 @@ void set_iounmap_nonlazy(void)
 	atomic_set(&vmap_lazy_nr, lazy_max_pages()+1);
 }
 
+/*
+ * Architectures whose caches need flushing on vunmap can split that work
+ * between the unmap of each lazily freed area and the purge which makes
+ * the addresses of a batch of areas available again.
+ */
+#ifndef ARCH_HAS_LAZY_VUNMAP_FLUSH
+static inline void flush_cache_vunmap_lazy(unsigned long start,
+					   unsigned long end)
+{
+	flush_cache_vunmap(start, end);
+}
+
+static inline void flush_cache_vunmap_purge(unsigned long start,
+					    unsigned long end)
+{
+}
+#endif
+
 /*
  * Purges all lazily-freed vmap areas.
  *
@@ -620,11 +665,19 @@ static void __purge_vmap_area_lazy(unsigned long *start, unsigned long *end,
 	}
 	rcu_read_unlock();
 
-	if (nr)
+	if (nr) {
 		atomic_sub(nr, &vmap_lazy_nr);
+		vmap_stat_inc(purges);
+		vmap_stat_add(purged_pages, nr);
+		if (sync)
+			vmap_stat_inc(sync_purges);
+	}
 
-	if (nr || force_flush)
+	if (nr || force_flush) {
+		flush_cache_vunmap_purge(*start, *end);
 		flush_tlb_kernel_range(*start, *end);
+		vmap_stat_inc(tlb_flushes);
+	}
 
 	if (nr) {
 		spin_lock(&vmap_area_lock);
@@ -684,7 +737,7 @@ static void free_unmap_vmap_area_noflush(struct vmap_area *va)
  */
 static void free_unmap_vmap_area(struct vmap_area *va)
 {
-	flush_cache_vunmap(va->va_start, va->va_end);
+	flush_cache_vunmap_lazy(va->va_start, va->va_end);
 	free_unmap_vmap_area_noflush(va);
 }
 
@@ -833,6 +886,7 @@ static struct vmap_block *new_vmap_block(gfp_t gfp_mask)
 	list_add_rcu(&vb->free_list, &vbq->free);
 	spin_unlock(&vbq->lock);
 	put_cpu_var(vmap_block_queue);
+	vmap_stat_inc(blocks_new);
 
 	return vb;
 }
@@ -857,6 +911,7 @@ static void free_vmap_block(struct vmap_block *vb)
 
 	free_vmap_area_noflush(vb->va);
 	call_rcu(&vb->rcu_head, rcu_free_vb);
+	vmap_stat_inc(blocks_freed);
 }
 
 static void purge_fragmented_blocks(int cpu)
@@ -968,6 +1023,7 @@ next:
 		goto again;
 	}
 
+	vmap_stat_inc(vb_allocs);
 	return (void *)addr;
 }
 
@@ -981,7 +1037,8 @@ static void vb_free(const void *addr, unsigned long size)
 	BUG_ON(size & ~PAGE_MASK);
 	BUG_ON(size > PAGE_SIZE*VMAP_MAX_ALLOC);
 
-	flush_cache_vunmap((unsigned long)addr, (unsigned long)addr + size);
+	flush_cache_vunmap_lazy((unsigned long)addr, (unsigned long)addr + size);
+	vmap_stat_inc(vb_frees);
 
 	order = get_order(size);
 
@@ -2575,3 +2632,78 @@ static int __init proc_vmalloc_init(void)
 module_init(proc_vmalloc_init);
 #endif
 
+
+#ifdef CONFIG_DEBUG_FS
+static int vmap_stats_show(struct seq_file *m, void *v)
+{
+	int cpu;
+
+	seq_printf(m, "lazy_max_pages %lu\n", lazy_max_pages());
+	seq_printf(m, "lazy_pages     %d\n", atomic_read(&vmap_lazy_nr));
+	seq_printf(m, "purges         %ld\n",
+		   atomic_long_read(&vmap_stats.purges));
+	seq_printf(m, "sync_purges    %ld\n",
+		   atomic_long_read(&vmap_stats.sync_purges));
+	seq_printf(m, "purged_pages   %ld\n",
+		   atomic_long_read(&vmap_stats.purged_pages));
+	seq_printf(m, "tlb_flushes    %ld\n",
+		   atomic_long_read(&vmap_stats.tlb_flushes));
+	seq_printf(m, "blocks_new     %ld\n",
+		   atomic_long_read(&vmap_stats.blocks_new));
+	seq_printf(m, "blocks_freed   %ld\n",
+		   atomic_long_read(&vmap_stats.blocks_freed));
+	seq_printf(m, "vb_allocs      %ld\n",
+		   atomic_long_read(&vmap_stats.vb_allocs));
+	seq_printf(m, "vb_frees       %ld\n",
+		   atomic_long_read(&vmap_stats.vb_frees));
+
+	/* Blocks which still have free space, and their usage */
+	seq_printf(m, "\ncpu   blocks     free    dirty\n");
+	for_each_possible_cpu(cpu) {
+		struct vmap_block_queue *vbq = &per_cpu(vmap_block_queue, cpu);
+		unsigned long nr = 0, free = 0, dirty = 0;
+		struct vmap_block *vb;
+
+		rcu_read_lock();
+		list_for_each_entry_rcu(vb, &vbq->free, free_list) {
+			spin_lock(&vb->lock);
+			nr++;
+			free += vb->free;
+			dirty += vb->dirty;
+			spin_unlock(&vb->lock);
+		}
+		rcu_read_unlock();
+
+		seq_printf(m, "%3d %8lu %8lu %8lu\n", cpu, nr, free, dirty);
+	}
+
+	return 0;
+}
+
+static int vmap_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, vmap_stats_show, NULL);
+}
+
+static const struct file_operations vmap_stats_fops = {
+	.open		= vmap_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init vmap_debugfs_init(void)
+{
+	struct dentry *dir;
+
+	dir = debugfs_create_dir("vmap", NULL);
+	if (!dir)
+		return -ENOMEM;
+
+	debugfs_create_file("stats", S_IRUSR, dir, NULL, &vmap_stats_fops);
+	debugfs_create_u32("lazy_max_pages", S_IRUSR | S_IWUSR, dir,
+			   &vmap_lazy_max_pages);
+	return 0;
+}
+module_init(vmap_debugfs_init);
+#endif
@@ -42,6 +42,9 @@
 #include <linux/delayacct.h>
 #include <linux/sysctl.h>
 #include <linux/oom.h>
+#include <linux/mem_notify.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
 
 #include <asm/tlbflush.h>
 #include <asm/div64.h>
@@ -112,6 +115,9 @@ struct scan_control {
 	 * are scanned.
 	 */
 	nodemask_t	*nodemask;
+
+	/* Reclaim on behalf of an allocation: account the stall times */
+	int direct_reclaim;
 };
 
 #define lru_to_page(_head) (list_entry((_head)->prev, struct page, lru))
@@ -184,6 +190,7 @@ static unsigned long zone_nr_lru_pages(struct zone *zone,
 void register_shrinker(struct shrinker *shrinker)
 {
 	shrinker->nr = 0;
+	memset(shrinker->stall_hist, 0, sizeof(shrinker->stall_hist));
 	down_write(&shrinker_rwsem);
 	list_add_tail(&shrinker->list, &shrinker_list);
 	up_write(&shrinker_rwsem);
@@ -202,6 +209,23 @@ void unregister_shrinker(struct shrinker *shrinker)
 EXPORT_SYMBOL(unregister_shrinker);
 
 #define SHRINK_BATCH 128
+
+/*
+ * Histograms of the time direct reclaim stalls allocating tasks, in
+ * all and in shrink_list() for each LRU list; struct shrinker has its
+ * own. See RECLAIM_HIST_BUCKETS for the buckets.
+ */
+static atomic_long_t reclaim_stall_hist[RECLAIM_HIST_BUCKETS];
+static atomic_long_t reclaim_lru_hist[NR_LRU_LISTS][RECLAIM_HIST_BUCKETS];
+
+static void reclaim_hist_add(atomic_long_t *hist, u64 delta_ns)
+{
+	u64 us = delta_ns;
+
+	do_div(us, NSEC_PER_USEC);
+	atomic_long_inc(&hist[min(fls64(us >> 4), RECLAIM_HIST_BUCKETS - 1)]);
+}
+
 /*
  * Call the shrink functions to age shrinkable caches
  *
@@ -219,10 +243,13 @@ EXPORT_SYMBOL(unregister_shrinker);
  * are eligible for the caller's allocation attempt.  It is used for balancing
  * slab reclaim versus page reclaim.
  *
+ * `direct' tells whether an allocation is waiting for it, whose stall times
+ * are accounted in the histogram of each shrinker.
+ *
  * Returns the number of slab objects which we shrunk.
  */
-unsigned long shrink_slab(unsigned long scanned, gfp_t gfp_mask,
-			unsigned long lru_pages)
+static unsigned long __shrink_slab(unsigned long scanned, gfp_t gfp_mask,
+				   unsigned long lru_pages, int direct)
 {
 	struct shrinker *shrinker;
 	unsigned long ret = 0;
@@ -240,6 +267,8 @@ unsigned long shrink_slab(unsigned long scanned, gfp_t gfp_mask,
 		unsigned long long delta;
 		unsigned long total_scan;
 		unsigned long max_pass;
+		unsigned long nr_freed = 0;
+		u64 start = 0;
 
 		max_pass = (*shrinker->shrink)(shrinker, 0, gfp_mask);
 		delta = (4 * scanned) / shrinker->seeks;
@@ -264,6 +293,9 @@ unsigned long shrink_slab(unsigned long scanned, gfp_t gfp_mask,
 		total_scan = shrinker->nr;
 		shrinker->nr = 0;
 
+		if (direct && total_scan >= SHRINK_BATCH)
+			start = local_clock();
+
 		while (total_scan >= SHRINK_BATCH) {
 			long this_scan = SHRINK_BATCH;
 			int shrink_ret;
@@ -275,13 +307,22 @@ unsigned long shrink_slab(unsigned long scanned, gfp_t gfp_mask,
 			if (shrink_ret == -1)
 				break;
 			if (shrink_ret < nr_before)
-				ret += nr_before - shrink_ret;
+				nr_freed += nr_before - shrink_ret;
 			count_vm_events(SLABS_SCANNED, this_scan);
 			total_scan -= this_scan;
 
 			cond_resched();
 		}
 
+		if (start) {
+			u64 delta_ns = local_clock() - start;
+
+			reclaim_hist_add(shrinker->stall_hist, delta_ns);
+			trace_mm_vmscan_direct_shrink_slab(shrinker, nr_freed,
+							   delta_ns);
+		}
+
+		ret += nr_freed;
 		shrinker->nr += total_scan;
 	}
 	up_read(&shrinker_rwsem);
@@ -290,6 +331,12 @@ out:
 	return ret;
 }
 
+unsigned long shrink_slab(unsigned long scanned, gfp_t gfp_mask,
+			unsigned long lru_pages)
+{
+	return __shrink_slab(scanned, gfp_mask, lru_pages, 0);
+}
+
 static void set_reclaim_mode(int priority, struct scan_control *sc,
 				   bool sync)
 {
@@ -1706,14 +1753,29 @@ static unsigned long shrink_list(enum lru_list lru, unsigned long nr_to_scan,
 	struct zone *zone, struct scan_control *sc, int priority)
 {
 	int file = is_file_lru(lru);
+	unsigned long nr_reclaimed = 0;
+	u64 start, delta_ns;
 
-	if (is_active_lru(lru)) {
-		if (inactive_list_is_low(zone, sc, file))
-		    shrink_active_list(nr_to_scan, zone, sc, priority, file);
+	if (is_active_lru(lru) && !inactive_list_is_low(zone, sc, file))
 		return 0;
+
+	/* Only direct reclaim stalls anybody */
+	start = sc->direct_reclaim ? local_clock() : 0;
+
+	if (is_active_lru(lru))
+		shrink_active_list(nr_to_scan, zone, sc, priority, file);
+	else
+		nr_reclaimed = shrink_inactive_list(nr_to_scan, zone, sc,
+						    priority, file);
+
+	if (start) {
+		delta_ns = local_clock() - start;
+		reclaim_hist_add(reclaim_lru_hist[lru], delta_ns);
+		trace_mm_vmscan_direct_shrink_lru(zone_to_nid(zone),
+				zone_idx(zone), lru, nr_reclaimed, delta_ns);
 	}
 
-	return shrink_inactive_list(nr_to_scan, zone, sc, priority, file);
+	return nr_reclaimed;
 }
 
 /*
@@ -1945,6 +2007,10 @@ restart:
 	}
 	sc->nr_reclaimed += nr_reclaimed;
 
+	if (scanning_global_lru(sc))
+		mem_notify_vmscan(sc->gfp_mask, sc->nr_scanned - nr_scanned,
+				  nr_reclaimed);
+
 	/*
 	 * Even if we did not try to evict anon pages at all, we want to
 	 * rebalance the anon lru active/inactive ratio.
@@ -2051,6 +2117,7 @@ static unsigned long do_try_to_free_pages(struct zonelist *zonelist,
 	struct zoneref *z;
 	struct zone *zone;
 	unsigned long writeback_threshold;
+	u64 start = local_clock();
 
 	get_mems_allowed();
 	delayacct_freepages_start();
@@ -2077,7 +2144,8 @@ static unsigned long do_try_to_free_pages(struct zonelist *zonelist,
 				lru_pages += zone_reclaimable_pages(zone);
 			}
 
-			shrink_slab(sc->nr_scanned, sc->gfp_mask, lru_pages);
+			__shrink_slab(sc->nr_scanned, sc->gfp_mask, lru_pages,
+				      sc->direct_reclaim);
 			if (reclaim_state) {
 				sc->nr_reclaimed += reclaim_state->reclaimed_slab;
 				reclaim_state->reclaimed_slab = 0;
@@ -2115,6 +2183,8 @@ static unsigned long do_try_to_free_pages(struct zonelist *zonelist,
 out:
 	delayacct_freepages_end();
 	put_mems_allowed();
+	if (sc->direct_reclaim)
+		reclaim_hist_add(reclaim_stall_hist, local_clock() - start);
 
 	if (sc->nr_reclaimed)
 		return sc->nr_reclaimed;
@@ -2148,6 +2218,7 @@ unsigned long try_to_free_pages(struct zonelist *zonelist, int order,
 		.order = order,
 		.mem_cgroup = NULL,
 		.nodemask = nodemask,
+		.direct_reclaim = 1,
 	};
 
 	trace_mm_vmscan_direct_reclaim_begin(order,
@@ -2905,6 +2976,73 @@ static int __init kswapd_init(void)
 
 module_init(kswapd_init)
 
+#ifdef CONFIG_PROC_FS
+static void reclaiminfo_show_hist(struct seq_file *m, atomic_long_t *hist)
+{
+	int i;
+
+	for (i = 0; i < RECLAIM_HIST_BUCKETS; i++)
+		seq_printf(m, " %8lu", atomic_long_read(&hist[i]));
+	seq_putc(m, '\n');
+}
+
+/*
+ * Provides /proc/reclaiminfo: histograms of the time direct reclaim
+ * stalled tasks, in all, in each LRU list and in each shrinker.
+ */
+static int reclaiminfo_show(struct seq_file *m, void *arg)
+{
+	static const char *lru_names[NR_LRU_LISTS] = {
+		"inactive_anon", "active_anon",
+		"inactive_file", "active_file",
+	};
+	struct shrinker *shrinker;
+	enum lru_list l;
+	int i;
+
+	seq_printf(m, "%-24s", "stall us <");
+	for (i = 0; i < RECLAIM_HIST_BUCKETS - 1; i++)
+		seq_printf(m, " %8u", 16 << i);
+	seq_printf(m, " %8s\n", "inf");
+
+	seq_printf(m, "%-24s", "total");
+	reclaiminfo_show_hist(m, reclaim_stall_hist);
+
+	for_each_evictable_lru(l) {
+		seq_printf(m, "%-24s", lru_names[l]);
+		reclaiminfo_show_hist(m, reclaim_lru_hist[l]);
+	}
+
+	down_read(&shrinker_rwsem);
+	list_for_each_entry(shrinker, &shrinker_list, list) {
+		seq_printf(m, "%-24pf", shrinker->shrink);
+		reclaiminfo_show_hist(m, shrinker->stall_hist);
+	}
+	up_read(&shrinker_rwsem);
+
+	return 0;
+}
+
+static int reclaiminfo_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, reclaiminfo_show, NULL);
+}
+
+static const struct file_operations reclaiminfo_fops = {
+	.open		= reclaiminfo_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init reclaiminfo_init(void)
+{
+	proc_create("reclaiminfo", S_IRUGO, NULL, &reclaiminfo_fops);
+	return 0;
+}
+module_init(reclaiminfo_init);
+#endif
+
 #ifdef CONFIG_NUMA
 /*
  * Zone reclaim mode
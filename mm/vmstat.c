@@ -957,6 +957,12 @@ static const char * const vmstat_text[] = {
 	"thp_split",
 #endif
 
+#ifdef CONFIG_READAHEAD_FEEDBACK
+	"readahead_pages",
+	"readahead_hit",
+	"readahead_waste",
+#endif
+
 #endif /* CONFIG_VM_EVENTS_COUNTERS */
 };
 
@@ -270,6 +270,30 @@ static enum export export_from_sec(struct elf_info *elf, unsigned int sec)
 		return export_unknown;
 }
 
+static const char *sec_name(struct elf_info *elf, int secindex);
+
+/*
+ * Before the final link, each exported symbol lives in its own
+ * ___ksymtab<sec>+<symbol> section, which the linker scripts sort by name.
+ */
+static enum export export_from_secname(struct elf_info *elf, unsigned int sec)
+{
+	const char *secname = sec_name(elf, sec);
+
+	if (strncmp(secname, "___ksymtab+", 11) == 0)
+		return export_plain;
+	else if (strncmp(secname, "___ksymtab_unused+", 18) == 0)
+		return export_unused;
+	else if (strncmp(secname, "___ksymtab_gpl+", 15) == 0)
+		return export_gpl;
+	else if (strncmp(secname, "___ksymtab_unused_gpl+", 22) == 0)
+		return export_unused_gpl;
+	else if (strncmp(secname, "___ksymtab_gpl_future+", 22) == 0)
+		return export_gpl_future;
+	else
+		return export_from_sec(elf, sec);
+}
+
 /**
  * Add an exported symbol - it may have already been added without a
  * CRC, in this case just update the CRC
@@ -567,7 +591,7 @@ static void handle_modversions(struct module *mod, struct elf_info *info,
 			       Elf_Sym *sym, const char *symname)
 {
 	unsigned int crc;
-	enum export export = export_from_sec(info, get_secindex(info, sym));
+	enum export export = export_from_secname(info, get_secindex(info, sym));
 
 	switch (sym->st_shndx) {
 	case SHN_COMMON:
@@ -1000,7 +1024,7 @@ const struct sectioncheck sectioncheck[] = {
 },
 /* Do not export init/exit functions or data */
 {
-	.fromsec = { "__ksymtab*", NULL },
+	.fromsec = { "__ksymtab*", "___ksymtab*", NULL },
 	.tosec   = { INIT_SECTIONS, EXIT_SECTIONS, NULL },
 	.mismatch = EXPORT_TO_INIT_EXIT,
 	.symbol_white_list = { DEFAULT_SYMBOL_WHITE_LIST, NULL },